@@ -0,0 +1,334 @@
+/**
+ * Conway's Game of Life simulation - benchmarks
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ * Runs a fixed set of workloads through the engine at each thread count and
+ * prints the timings as JSON, one result to a line. Given the JSON of an
+ * earlier run it flags the workloads that got slower or changed their result.
+ *
+ * 		life-bench --out base.json
+ * 		life-bench --baseline base.json
+ *
+ */
+
+#include "engine.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * DEFAULTS
+ */
+int threads = 0;							//	one thread count to run, 0 = 1, 2, 4 ... up to one per core
+double scale = 1;							//	multiplies every workload's generations
+int repeats = 3;							//	runs of each workload, the fastest is kept
+std::string only;							//	run just the workloads whose names start with this
+std::string out;							//	file to write the JSON to, stdout if empty
+std::string baseline;						//	JSON of an earlier run to compare against
+double tolerance = 0.10;					//	slowdown allowed before a result counts as a regression
+
+/**
+ * @brief Workload
+ * @details One benchmark: a grid, a rule and either a random fill or a small shape
+ * 			stamped at a spacing, as rows of o and . A spacing of 0 stamps the
+ * 			shape once in the middle of the grid.
+ */
+struct Workload{
+	const char * name;
+	int wide, tall;
+	const char * rule;
+	double density;							//	random fill, when there's no shape
+	const char * shape;						//	rows separated by |
+	int spacing;
+	unsigned long long gens;
+};
+static const Workload workloads[] = {
+	{ "soup-1k-25",		1024,	1024,	"B3/S23",	0.25,	0,							0,		400 },
+	{ "soup-1k-50",		1024,	1024,	"B3/S23",	0.50,	0,							0,		400 },
+	{ "soup-4k-50",		4096,	4096,	"B3/S23",	0.50,	0,							0,		100 },
+	{ "soup-16k-35",	16384,	16384,	"B3/S23",	0.35,	0,							0,		10 },
+	{ "gliders-8k",		8192,	8192,	"B3/S23",	0,		".o.|..o|ooo",				64,		200 },
+	{ "r-pentomino",	2048,	2048,	"B3/S23",	0,		".oo|oo.|.o.",				0,		1200 },
+	{ "replicator",		2048,	2048,	"B36/S23",	0,		"..ooo|.o..o|o...o|o..o.|ooo..",	0,	1500 },
+};
+
+/**
+ * @brief Result
+ * @details Timing of one workload at one thread count
+ */
+struct Result{
+	std::string name;
+	int threads;
+	unsigned long long gens;
+	double seconds;
+	double cells;							//	cell updates per second
+	double rate;							//	generations per second
+	double scaling;							//	rate over the one thread rate, 0 without one
+	size_t memory;							//	bytes held by the engine
+	unsigned long long population;
+};
+
+/**
+ * @brief usage
+ * @details Print the options to stderr
+ */
+static void usage(const char * name){
+	std::fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --threads N      run only this many threads, 0 for 1, 2, 4 ... per core (%d)\n"
+		"  --scale F        multiply every workload's generations (%g)\n"
+		"  --repeat N       runs of each workload, the fastest is kept (%d)\n"
+		"  --only NAME      run the workloads whose names start with NAME\n"
+		"  --out FILE       write the JSON here instead of stdout\n"
+		"  --baseline FILE  compare against an earlier run, exit 1 on a regression\n"
+		"  --tolerance F    slowdown allowed before it's a regression (%g)\n"
+		"  --list           print the workloads\n",
+		name, threads, scale, repeats, tolerance);
+}
+/**
+ * @brief parse
+ * @details Read the command line into the defaults, false on a bad option
+ */
+static bool parse(int argc, char ** argv){
+	for(int i = 1; i < argc; i++){
+		std::string opt = argv[i];
+		if(opt == "--list"){
+			for(const Workload & w : workloads)
+				std::printf("%-12s %6dx%-6d %-8s %llu generations\n", w.name, w.wide, w.tall, w.rule, w.gens);
+			std::exit(EXIT_SUCCESS);
+		}
+		if(opt == "--help")
+			return false;
+		if(i + 1 >= argc){
+			std::fprintf(stderr, "%s: missing value for %s\n", argv[0], opt.c_str());
+			return false;
+		}
+		const char * val = argv[++i];
+		char * end = 0;
+		bool ok = true;
+		if(opt == "--threads"){
+			long n = std::strtol(val, &end, 10);
+			ok = end != val && *end == 0 && n >= 0 && n <= 1024;
+			threads = static_cast<int>(n);
+		}
+		else if(opt == "--scale"){
+			scale = std::strtod(val, &end);
+			ok = end != val && *end == 0 && scale > 0;
+		}
+		else if(opt == "--repeat"){
+			long n = std::strtol(val, &end, 10);
+			ok = end != val && *end == 0 && n > 0 && n <= 1000;
+			repeats = static_cast<int>(n);
+		}
+		else if(opt == "--tolerance"){
+			tolerance = std::strtod(val, &end);
+			ok = end != val && *end == 0 && tolerance >= 0;
+		}
+		else if(opt == "--only"){
+			only = val;
+		}
+		else if(opt == "--out"){
+			out = val;
+		}
+		else if(opt == "--baseline"){
+			baseline = val;
+		}
+		else{
+			std::fprintf(stderr, "%s: unknown option %s\n", argv[0], opt.c_str());
+			return false;
+		}
+		if(!ok){
+			std::fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], opt.c_str(), val);
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * @brief stamp
+ * @details Draw a workload's shape with its top left at (x,y)
+ */
+static void stamp(Engine & engine, const char * shape, int x, int y){
+	int dx = 0;
+	for(const char * c = shape; *c; c++){
+		if(*c == '|'){
+			y++;
+			dx = 0;
+			continue;
+		}
+		if(*c == 'o' && x + dx < engine.width() && y < engine.height())
+			engine.set(x + dx, y, true);
+		dx++;
+	}
+}
+/**
+ * @brief measure
+ * @details Set up a workload on a fresh engine and time its generations
+ */
+static Result measure(const Workload & w, int threads){
+	Rule rule;
+	rule.parse(w.rule);
+	Engine engine(w.wide, w.tall, rule, 0, threads);
+	if(!w.shape)
+		engine.fill(1, w.density);
+	else if(w.spacing == 0)
+		stamp(engine, w.shape, w.wide / 2, w.tall / 2);
+	else{
+		for(int y = 0; y + w.spacing <= w.tall; y += w.spacing)
+			for(int x = 0; x + w.spacing <= w.wide; x += w.spacing)
+				stamp(engine, w.shape, x, y);
+	}
+	Result r;
+	r.name = w.name;
+	r.threads = engine.workers().size();
+	r.gens = std::max(1ULL, static_cast<unsigned long long>(w.gens * scale));
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point began = Clock::now();
+	engine.run(r.gens);
+	r.seconds = std::chrono::duration<double>(Clock::now() - began).count();
+	r.rate = r.seconds > 0 ? r.gens / r.seconds : 0;
+	r.cells = r.rate * w.wide * w.tall;
+	r.scaling = 0;
+	r.memory = 2 * engine.cells().imageWords() * sizeof(uint64_t)
+			+ 3 * static_cast<size_t>(engine.tiles().across() + 2) * (engine.tiles().down() + 2);
+	r.population = engine.population();
+	return r;
+}
+/**
+ * @brief json
+ * @details One result as a line of JSON
+ */
+static std::string json(const Result & r){
+	char line[512], scaling[32] = "null";	//	no one thread run to scale against
+	if(r.scaling > 0)
+		std::snprintf(scaling, sizeof(scaling), "%.3f", r.scaling);
+	std::snprintf(line, sizeof(line),
+		"{\"name\": \"%s\", \"threads\": %d, \"gens\": %llu, \"seconds\": %.6f, \"gens_per_sec\": %.6g, "
+		"\"cells_per_sec\": %.6g, \"scaling\": %s, \"memory_bytes\": %llu, \"population\": %llu}",
+		r.name.c_str(), r.threads, r.gens, r.seconds, r.rate, r.cells, scaling,
+		static_cast<unsigned long long>(r.memory), r.population);
+	return line;
+}
+/**
+ * @brief field
+ * @details The value after "key": in a line of our own JSON, empty if it isn't there
+ */
+static std::string field(const std::string & line, const char * key){
+	std::string tag = std::string("\"") + key + "\": ";
+	size_t at = line.find(tag);
+	if(at == std::string::npos)
+		return std::string();
+	at += tag.size();
+	if(at < line.size() && line[at] == '"')
+		return line.substr(at + 1, line.find('"', at + 1) - at - 1);
+	return line.substr(at, line.find_first_of(",}", at) - at);
+}
+/**
+ * @brief compare
+ * @details Check the results against the baseline file: a workload is a regression
+ * 			if it ran more than the tolerance slower at the same thread count, and
+ * 			changed if it ended on a different population, which means the engine
+ * 			no longer computes the same thing. Both are reported to stderr.
+ * @return number of regressions and changes
+ */
+static int compare(const std::vector<Result> & results, const std::string & path){
+	std::ifstream in(path.c_str());
+	if(!in){
+		std::fprintf(stderr, "can't read baseline %s\n", path.c_str());
+		return 1;
+	}
+	int bad = 0, matched = 0;
+	std::string line;
+	while(std::getline(in, line)){
+		std::string name = field(line, "name");
+		if(name.empty())
+			continue;
+		int t = std::atoi(field(line, "threads").c_str());
+		double cells = std::atof(field(line, "cells_per_sec").c_str());
+		unsigned long long pop = std::strtoull(field(line, "population").c_str(), 0, 10);
+		unsigned long long gens = std::strtoull(field(line, "gens").c_str(), 0, 10);
+		for(const Result & r : results){
+			if(r.name != name || r.threads != t)
+				continue;
+			matched++;
+			double change = cells > 0 ? r.cells / cells - 1 : 0;
+			const char * verdict = change < -tolerance ? "REGRESSION" : change > tolerance ? "faster" : "ok";
+			if(r.gens == gens && r.population != pop){
+				verdict = "CHANGED";
+				bad++;
+			}
+			else if(change < -tolerance)
+				bad++;
+			std::fprintf(stderr, "%-12s x%-3d %10.4g -> %10.4g cells/sec %+6.1f%%  %s\n",
+					name.c_str(), t, cells, r.cells, change * 100, verdict);
+		}
+	}
+	if(matched == 0)
+		std::fprintf(stderr, "nothing in %s matches this run\n", path.c_str());
+	return bad;
+}
+
+int main(int argc, char ** argv){
+	if(!parse(argc, argv)){
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::vector<int> counts;
+	int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	if(threads > 0)
+		counts.push_back(threads);
+	else{
+		for(int t = 1; t < cores; t *= 2)
+			counts.push_back(t);
+		counts.push_back(cores);
+	}
+
+	std::vector<Result> results;
+	for(const Workload & w : workloads){
+		if(std::string(w.name).compare(0, only.size(), only) != 0)
+			continue;
+		double single = 0;
+		for(int t : counts){
+			Result r = measure(w, t);
+			for(int k = 1; k < repeats; k++){	//	noise only ever slows a run down
+				Result again = measure(w, t);
+				if(again.seconds < r.seconds)
+					r = again;
+			}
+			if(t == 1)
+				single = r.rate;
+			r.scaling = single > 0 ? r.rate / single : 0;
+			results.push_back(r);
+			std::fprintf(stderr, "%-12s x%-3d %10.4g cells/sec %10.4g gen/s\n", r.name.c_str(), r.threads, r.cells, r.rate);
+		}
+	}
+
+	std::string text = "{\"kernel\": \"" + std::string(kernelName()) + "\", \"cores\": " + std::to_string(cores) + ", \"results\": [\n";
+	for(size_t i = 0; i < results.size(); i++)
+		text += "  " + json(results[i]) + (i + 1 < results.size() ? ",\n" : "\n");
+	text += "]}\n";
+	if(out.empty())
+		std::fwrite(text.data(), 1, text.size(), stdout);
+	else{
+		std::FILE * f = std::fopen(out.c_str(), "w");
+		bool ok = f && std::fwrite(text.data(), 1, text.size(), f) == text.size();
+		if(f)
+			ok = (std::fclose(f) == 0) && ok;
+		if(!ok){
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], out.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	if(!baseline.empty() && compare(results, baseline) > 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
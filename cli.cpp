@@ -0,0 +1,606 @@
+/**
+ * Conway's Game of Life simulation - headless runner
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ * Runs the engine with no window for batch work on machines without a
+ * display, then reports the final state and how long it took.
+ *
+ * 		life-cli --width 4096 --height 4096 --rule B3/S23 --gens 1000
+ *
+ */
+
+#include "engine.h"
+#include "hashlife.h"
+#include "world.h"
+#include "snapshot.h"
+#include "pattern.h"
+#include "record.h"
+#include "profile.h"
+#include "cycles.h"
+#include "ensemble.h"
+#include "slab.h"
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+/**
+ * DEFAULTS
+ */
+int wide = 640;								//	grid width in cells
+int tall = 480;								//	grid height in cells
+std::string rulestring = "B36/S23";			//	birth/survive rule, HighLife
+unsigned seed = 0;							//	fill seed, 0 = from the clock
+double density = 0.5;						//	chance of each cell being alive in the fill
+unsigned long long gens = 1000;				//	generations to run
+int threads = 0;							//	stepping threads, 0 = one per core
+int block = 0;								//	generations per pass over memory, 0 = from the cache sizes
+int topology = 0;							//	edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+std::string engine = "grid";				//	grid, hashlife or world
+bool dump = false;							//	print the final cells
+std::string load;							//	snapshot to start from instead of a fill
+std::string save;							//	snapshot to write at the end
+bool rle = false;							//	compress the saved snapshot
+std::string pattern;						//	pattern file to start from instead of a fill
+long long atX = 0, atY = 0;					//	where the pattern's top left goes
+std::string exported;						//	pattern file to write the final cells to
+bool ruled = false;							//	--rule given, so a pattern's own rule is ignored
+std::string logged;							//	run log to record the generations into
+unsigned long long keyframes = 1000;		//	generations between keyframes in the run log
+std::string replay;							//	run log to start from instead of a fill
+unsigned long long seek = 0;				//	generation of the run log to start from
+std::string profile;						//	file to write the step and snapshot timings to
+std::string series;							//	file to write each generation's counts to
+bool cycles = false;						//	watch for the grid repeating and skip the rest of the run
+unsigned long long ensemble = 0;			//	soups to run side by side instead of one grid
+unsigned long long batch = 64;				//	generations an ensemble soup runs per task
+std::string results = "ensemble.csv";		//	file the ensemble's results go to
+int ranks = 0;								//	processes to split the grid between, 0 = just this one
+int halo = 4;								//	rows swapped with each neighbouring rank, and generations between swaps
+
+/**
+ * @brief usage
+ * @details Print the options to stderr
+ */
+static void usage(const char * name){
+	std::fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --width N        grid width in cells (%d)\n"
+		"  --height N       grid height in cells (%d)\n"
+		"  --rule B../S..   birth/survive rule (%s)\n"
+		"  --seed N         fill seed, 0 for the clock (%u)\n"
+		"  --density P      chance of each cell being alive in the fill, 0 to 1 (%g)\n"
+		"  --gens N         generations to run (%llu)\n"
+		"  --threads N      stepping threads, 0 for one per core (%d)\n"
+		"  --block N        generations per pass over memory, 0 to fit the caches,\n"
+		"                   1 for one generation at a time (%d)\n"
+		"  --topology T     dead, torus, klein or mirror (dead)\n"
+		"  --engine E       grid, hashlife or world (%s)\n"
+		"  --dump           print the final cells, o live . dead\n"
+		"  --load FILE      start from a snapshot, which sets size, rule and topology\n"
+		"  --save FILE      write a snapshot of the final cells\n"
+		"  --rle            compress the snapshot body\n"
+		"  --cycles         once the grid repeats, jump to the last generation (grid engine)\n"
+		"  --pattern FILE   start from an RLE, .cells or .mc pattern on an empty grid\n"
+		"  --at X,Y         cell the pattern's top left goes on (0,0)\n"
+		"  --export FILE    write the final cells as a pattern, format by extension\n"
+		"  --record FILE    log every generation to a run log (grid engine only)\n"
+		"  --keyframes N    generations between keyframes in the run log (%llu)\n"
+		"  --replay FILE    start from a run log, which sets size, rule and topology\n"
+		"  --seek N         generation of the run log to start from (its first)\n"
+		"  --ensemble N     run N soups of the grid size, seeds from --seed up, each\n"
+		"                   until it repeats or --gens\n"
+		"  --batch N        generations per ensemble task (%llu)\n"
+		"  --results FILE   where the ensemble's results go, as CSV (%s)\n"
+		"  --ranks N        split the grid into N bands of rows, each stepped by a\n"
+		"                   process of its own (grid engine, fill or pattern)\n"
+		"  --halo N         rows swapped between neighbouring ranks, and generations\n"
+		"                   between swaps (%d)\n"
+		"  --profile FILE   write step and snapshot timings as JSON\n"
+		"  --stats FILE     write each generation's population, births, deaths and\n"
+		"                   bounding box as CSV (grid engine only)\n",
+		name, wide, tall, rulestring.c_str(), seed, density, gens, threads, block, engine.c_str(), keyframes, batch, results.c_str(), halo);
+}
+static const char * names[] = { "dead", "torus", "klein", "mirror" };	//	--topology, by number
+/**
+ * @brief edges
+ * @details Topology number for a name, -1 if unknown
+ */
+static int edges(const char * name){
+	for(int i = 0; i < 4; i++){
+		if(std::strcmp(name, names[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+/**
+ * @brief number
+ * @details Parse a whole non-negative number, false if it isn't one
+ */
+static bool number(const char * text, unsigned long long & out){
+	char * end = 0;
+	if(!*text || *text == '-')
+		return false;
+	out = std::strtoull(text, &end, 10);
+	return *end == 0;
+}
+/**
+ * @brief parse
+ * @details Read the command line into the defaults, false on a bad option
+ */
+static bool parse(int argc, char ** argv){
+	for(int i = 1; i < argc; i++){
+		std::string opt = argv[i];
+		if(opt == "--dump" || opt == "--rle" || opt == "--cycles"){
+			(opt == "--dump" ? dump : opt == "--rle" ? rle : cycles) = true;
+			continue;
+		}
+		if(opt == "--help")
+			return false;
+		if(i + 1 >= argc){
+			std::fprintf(stderr, "%s: missing value for %s\n", argv[0], opt.c_str());
+			return false;
+		}
+		const char * val = argv[++i];
+		unsigned long long n = 0;
+		bool ok = true;
+		if(opt == "--width"){
+			ok = number(val, n) && n > 0 && n <= 1 << 20;
+			wide = static_cast<int>(n);
+		}
+		else if(opt == "--height"){
+			ok = number(val, n) && n > 0 && n <= 1 << 20;
+			tall = static_cast<int>(n);
+		}
+		else if(opt == "--seed"){
+			ok = number(val, n) && n <= 0xffffffffULL;
+			seed = static_cast<unsigned>(n);
+		}
+		else if(opt == "--density"){
+			char * end = 0;
+			density = std::strtod(val, &end);
+			ok = end != val && *end == 0 && density >= 0 && density <= 1;
+		}
+		else if(opt == "--gens"){
+			ok = number(val, gens);
+		}
+		else if(opt == "--threads"){
+			ok = number(val, n) && n <= 1024;
+			threads = static_cast<int>(n);
+		}
+		else if(opt == "--block"){
+			ok = number(val, n) && n <= 1024;
+			block = static_cast<int>(n);
+		}
+		else if(opt == "--rule"){
+			rulestring = val;
+			ruled = true;
+		}
+		else if(opt == "--load"){
+			load = val;
+		}
+		else if(opt == "--save"){
+			save = val;
+		}
+		else if(opt == "--record"){
+			logged = val;
+		}
+		else if(opt == "--keyframes"){
+			ok = number(val, keyframes) && keyframes > 0 && keyframes <= 0xffffffffULL;
+		}
+		else if(opt == "--replay"){
+			replay = val;
+		}
+		else if(opt == "--seek"){
+			ok = number(val, seek);
+		}
+		else if(opt == "--ensemble"){
+			ok = number(val, ensemble) && ensemble > 0;
+		}
+		else if(opt == "--batch"){
+			ok = number(val, batch) && batch > 0 && batch <= 0xffffffffULL;
+		}
+		else if(opt == "--results"){
+			results = val;
+		}
+		else if(opt == "--ranks"){
+			ok = number(val, n) && n > 0 && n <= 1024;
+			ranks = static_cast<int>(n);
+		}
+		else if(opt == "--halo"){
+			ok = number(val, n) && n > 0 && n <= 1 << 20;
+			halo = static_cast<int>(n);
+		}
+		else if(opt == "--profile"){
+			profile = val;
+		}
+		else if(opt == "--stats"){
+			series = val;
+		}
+		else if(opt == "--pattern"){
+			pattern = val;
+		}
+		else if(opt == "--export"){
+			exported = val;
+			ok = patternFormat(exported) != Pattern::UNKNOWN;
+		}
+		else if(opt == "--at"){
+			char * end = 0;
+			atX = std::strtoll(val, &end, 10);
+			ok = end != val && *end == ',';
+			if(ok){
+				const char * rest = end + 1;
+				atY = std::strtoll(rest, &end, 10);
+				ok = end != rest && *end == 0;
+			}
+		}
+		else if(opt == "--topology"){
+			topology = edges(val);
+			ok = topology >= 0;
+		}
+		else if(opt == "--engine"){
+			engine = val;
+			ok = engine == "grid" || engine == "hashlife" || engine == "world";
+		}
+		else{
+			std::fprintf(stderr, "%s: unknown option %s\n", argv[0], opt.c_str());
+			return false;
+		}
+		if(!ok){
+			std::fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], opt.c_str(), val);
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * @brief sample
+ * @details Write a line of CSV with the counts of the generation just stepped,
+ * 			as the kernel worked them out
+ * @return false if the line couldn't be written
+ */
+static bool sample(std::FILE * out, const Engine & engine){
+	if(!out)
+		return true;
+	Stats s = engine.stats();
+	return std::fprintf(out, "%llu,%llu,%llu,%llu,%d,%d,%d,%d\n", engine.generation(),
+			static_cast<unsigned long long>(s.population), static_cast<unsigned long long>(s.births),
+			static_cast<unsigned long long>(s.deaths), s.x0, s.y0, s.x1, s.y1) > 0;
+}
+/**
+ * @brief print
+ * @details Write the grid as rows of o and .
+ */
+static void print(const Grid & grid){
+	std::string line(grid.width() + 1, '\n');
+	for(int y = 0; y < grid.height(); y++){
+		for(int x = 0; x < grid.width(); x++)
+			line[x] = grid.get(x, y) ? 'o' : '.';
+		std::fwrite(line.data(), 1, line.size(), stdout);
+	}
+}
+
+/**
+ * @brief patternRule
+ * @details Take the --pattern file's own rule, unless --rule was given
+ * @return false if the pattern can't be read
+ */
+static bool patternRule(const char * name, Rule & rule){
+	Pattern info;
+	if(!readPattern(pattern, [](long long, long long, long long){}, &info, 0, 0, -1, -1)){
+		std::fprintf(stderr, "%s: can't read pattern %s\n", name, pattern.c_str());
+		return false;
+	}
+	Rule own;
+	if(!info.rule.empty() && own.parse(info.rule) && !ruled)
+		rule = own;
+	else if(!info.rule.empty() && ruled && own.parse(info.rule) && own.str() != rule.str())
+		std::fprintf(stderr, "%s: pattern rule %s overridden by --rule %s\n", name, info.rule.c_str(), rule.str().c_str());
+	return true;
+}
+/**
+ * @brief decomposed
+ * @details Run the grid split between --ranks processes, each stepping a band of
+ * 			rows and swapping --halo rows with its neighbours every --halo
+ * 			generations, then report as a single run would. Every rank comes back
+ * 			through here; only rank 0 prints or writes anything.
+ * @return exit status for this process
+ */
+static int decomposed(const char * name, const Rule & rule){
+	std::unique_ptr<SocketTransport> link = SocketTransport::launch(ranks);
+	if(!link){
+		std::fprintf(stderr, "%s: can't start %d ranks\n", name, ranks);
+		return EXIT_FAILURE;
+	}
+	bool root = link->rank() == 0;
+	Slab slab(*link, wide, tall, rule, topology, halo, threads);
+	slab.engine().block(block);
+	if(!pattern.empty()){
+		placePattern(pattern, slab.engine(), atX, atY - (slab.first() - slab.top()));
+		seed = 0;
+	}
+	else
+		slab.fill(seed, density);
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point began = Clock::now();
+	bool ok = slab.run(gens);
+	double secs = std::chrono::duration<double>(Clock::now() - began).count();
+	uint64_t mine = slab.population(), pop = 0;
+	std::vector<char> all;
+	ok = ok && link->gather(&mine, sizeof(mine), all);
+	for(size_t i = 0; ok && root && i + sizeof(mine) <= all.size(); i += sizeof(mine)){
+		std::memcpy(&mine, &all[i], sizeof(mine));
+		pop += mine;
+	}
+	Grid whole;
+	if(ok && (dump || !save.empty() || !exported.empty()))
+		ok = slab.gather(whole);
+	if(!root)
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	ok = link->finish() && ok;
+	if(!ok){
+		std::fprintf(stderr, "%s: lost touch with the other ranks\n", name);
+		return EXIT_FAILURE;
+	}
+
+	std::printf("rule        %s\n", rule.str().c_str());
+	std::printf("engine      grid (%s, %d threads, %d ranks)\n", kernelName(), slab.engine().workers().size(), ranks);
+	std::printf("grid        %dx%d %s, %d halo rows\n", wide, tall, names[topology], halo);
+	std::printf("seed        %u\n", seed);
+	std::printf("generations %llu, now at %llu\n", gens, gens);
+	std::printf("population  %llu\n", static_cast<unsigned long long>(pop));
+	std::printf("seconds     %.6f\n", secs);
+	if(secs > 0)
+		std::printf("cells/sec   %.4g\n", static_cast<double>(wide) * tall * gens / secs);
+	if(dump)
+		print(whole);
+	if(!save.empty()){
+		Engine out(Grid(whole), rule, topology, 1, gens, seed);
+		if(!saveSnapshot(save, out, rle)){
+			std::fprintf(stderr, "%s: can't save snapshot %s\n", name, save.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	if(!exported.empty() && !writePattern(exported, whole, patternFormat(exported), rule.str())){
+		std::fprintf(stderr, "%s: can't export pattern %s\n", name, exported.c_str());
+		return EXIT_FAILURE;
+	}
+	if(!profile.empty() && !Profile::write(profile)){
+		std::fprintf(stderr, "%s: can't write %s\n", name, profile.c_str());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char ** argv){
+	if(!parse(argc, argv)){
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	Rule rule;
+	if(!rule.parse(rulestring)){
+		std::fprintf(stderr, "%s: bad rule %s\n", argv[0], rulestring.c_str());
+		return EXIT_FAILURE;
+	}
+	if(seed == 0)
+		seed = static_cast<unsigned>(std::time(NULL));
+	if(ensemble > 0){
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point began = Clock::now();
+		std::vector<Soup> soups = runEnsemble(wide, tall, rule, topology, density, seed,
+				static_cast<size_t>(ensemble), gens, threads, static_cast<unsigned>(batch));
+		double secs = std::chrono::duration<double>(Clock::now() - began).count();
+		unsigned long long settled = 0, stepped = 0;
+		double stable = 0;
+		for(const Soup & s : soups){
+			stepped += s.generations;
+			if(s.period){
+				settled++;
+				stable += s.stable;
+			}
+		}
+		std::printf("rule        %s\n", rule.str().c_str());
+		std::printf("soups       %llu of %dx%d %s, seeds %u to %llu\n", ensemble, wide, tall, names[topology],
+				seed, seed + ensemble - 1);
+		std::printf("settled     %llu, at generation %.1f on average\n", settled, settled ? stable / settled : 0.0);
+		std::printf("seconds     %.6f\n", secs);
+		if(secs > 0)
+			std::printf("soups/sec   %.4g, %.4g cells/sec\n", ensemble / secs, static_cast<double>(wide) * tall * stepped / secs);
+		if(!writeEnsemble(results, soups)){
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], results.c_str());
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+	if((!logged.empty() || cycles || !series.empty()) && engine != "grid"){
+		std::fprintf(stderr, "%s: %s needs --engine grid\n", argv[0], cycles ? "--cycles" : !logged.empty() ? "--record" : "--stats");
+		return EXIT_FAILURE;
+	}
+	if((!logged.empty() || !series.empty()) && cycles){
+		std::fprintf(stderr, "%s: --cycles skips generations %s would need\n", argv[0], logged.empty() ? "--stats" : "--record");
+		return EXIT_FAILURE;
+	}
+	if(ranks > 0){
+		if(engine != "grid" || !load.empty() || !replay.empty() || !logged.empty() || !series.empty() || cycles){
+			std::fprintf(stderr, "%s: --ranks runs the grid engine from a fill or --pattern only\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		if(tall / ranks < halo){
+			std::fprintf(stderr, "%s: %d ranks leave bands under the %d halo rows\n", argv[0], ranks, halo);
+			return EXIT_FAILURE;
+		}
+		if(!pattern.empty() && !patternRule(argv[0], rule))
+			return EXIT_FAILURE;
+		return decomposed(argv[0], rule);
+	}
+
+	//	Every engine starts from the same grid, so the results can be compared
+	std::unique_ptr<Engine> start;
+	if(!load.empty()){
+		start = loadSnapshot(load, threads);
+		if(!start){
+			std::fprintf(stderr, "%s: can't load snapshot %s\n", argv[0], load.c_str());
+			return EXIT_FAILURE;
+		}
+		rule = start->rule();
+		wide = start->width();
+		tall = start->height();
+		topology = start->topology();
+		seed = start->seed();
+	}
+	else if(!replay.empty()){
+		Replay log;
+		if(log.open(replay))
+			start = log.seek(seek ? seek : log.first(), threads);
+		if(!start){
+			std::fprintf(stderr, "%s: can't replay %s to generation %llu\n", argv[0], replay.c_str(), seek);
+			return EXIT_FAILURE;
+		}
+		rule = start->rule();
+		wide = start->width();
+		tall = start->height();
+		topology = start->topology();
+		seed = start->seed();
+	}
+	else if(!pattern.empty()){
+		if(!patternRule(argv[0], rule))
+			return EXIT_FAILURE;
+		start.reset(new Engine(wide, tall, rule, topology, threads));
+		placePattern(pattern, *start, atX, atY);
+		seed = 0;
+	}
+	else{
+		start.reset(new Engine(wide, tall, rule, topology, threads));
+		start->fill(seed, density);
+	}
+	Engine & grid = *start;
+	grid.block(block);
+	unsigned long long first = grid.generation();
+	Grid final(wide, tall);
+	uint64_t pop = 0;
+	Cycles watch;
+	std::FILE * counts = 0;
+	if(!series.empty()){
+		counts = std::fopen(series.c_str(), "w");
+		if(!counts || std::fprintf(counts, "generation,population,births,deaths,x0,y0,x1,y1\n") < 0){
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], series.c_str());
+			return EXIT_FAILURE;
+		}
+		grid.count(true);
+	}
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point began = Clock::now();
+	if(engine == "grid" && !logged.empty()){
+		Recorder recorder;
+		bool ok = recorder.open(logged, grid, static_cast<unsigned>(keyframes));
+		for(unsigned long long i = 0; ok && i < gens; i++){
+			grid.step();
+			ok = recorder.step(grid) && sample(counts, grid);
+		}
+		if(!recorder.close() || !ok){
+			std::fprintf(stderr, "%s: can't record %s\n", argv[0], logged.c_str());
+			return EXIT_FAILURE;
+		}
+		pop = grid.population();
+	}
+	else if(engine == "grid" && cycles){
+		//	Once the grid repeats every p generations, the state at the end is the
+		//	one (end - now) % p generations on, so only those are stepped
+		unsigned long long target = first + gens;
+		watch.update(grid);
+		while(grid.generation() < target){
+			grid.step();
+			watch.update(grid);
+			if(watch.period()){
+				unsigned long long left = target - grid.generation();
+				grid.run(left % watch.period());
+				grid.advance(left - left % watch.period());
+			}
+		}
+		pop = grid.population();
+	}
+	else if(engine == "grid" && counts){
+		bool ok = true;
+		for(unsigned long long i = 0; ok && i < gens; i++){
+			grid.step();
+			ok = sample(counts, grid);
+		}
+		if(!ok){
+			std::fprintf(stderr, "%s: can't write %s\n", argv[0], series.c_str());
+			return EXIT_FAILURE;
+		}
+		pop = grid.population();
+	}
+	else if(engine == "grid"){
+		grid.run(gens);
+		pop = grid.population();
+	}
+	else if(engine == "hashlife"){
+		HashLife hash(rule);
+		hash.load(grid.cells());
+		for(int k = 63; k >= 0; k--){	//	2^k generations per step, so one step per set bit
+			if(gens >> k & 1)
+				hash.step(k);
+		}
+		pop = hash.population();
+		if(dump || !save.empty() || !exported.empty())
+			hash.store(final);
+	}
+	else{
+		World world(rule);
+		world.load(grid.cells());
+		for(unsigned long long i = 0; i < gens; i++)
+			world.step(grid.workers());
+		pop = world.population();
+		if(dump || !save.empty() || !exported.empty())
+			world.store(final);
+	}
+	double secs = std::chrono::duration<double>(Clock::now() - began).count();
+	if(counts && std::fclose(counts) != 0){
+		std::fprintf(stderr, "%s: can't write %s\n", argv[0], series.c_str());
+		return EXIT_FAILURE;
+	}
+
+	std::printf("rule        %s\n", rule.str().c_str());
+	std::printf("engine      %s (%s, %d threads)\n", engine.c_str(), kernelName(), grid.workers().size());
+	if(engine == "grid" && logged.empty() && series.empty() && !cycles && grid.blockDepth() > 1)
+		std::printf("blocking    %d generations a pass\n", grid.blockDepth());
+	std::printf("grid        %dx%d %s\n", wide, tall, engine == "grid" ? names[topology] : "start, unbounded");
+	std::printf("seed        %u\n", seed);
+	std::printf("generations %llu, now at %llu\n", gens, first + gens);
+	std::printf("population  %llu\n", static_cast<unsigned long long>(pop));
+	if(cycles && watch.period())
+		std::printf("period      %llu from generation %llu\n", watch.period(), watch.since());
+	else if(cycles)
+		std::printf("period      none found\n");
+	std::printf("seconds     %.6f\n", secs);
+	if(engine == "grid" && secs > 0)
+		std::printf("cells/sec   %.4g\n", static_cast<double>(wide) * tall * gens / secs);
+	if(dump)
+		print(engine == "grid" ? grid.cells() : final);
+	if(!save.empty()){
+		std::unique_ptr<Engine> out;
+		if(engine != "grid")	//	the window of the unbounded universe over the starting grid, copied as --export still wants it
+			out.reset(new Engine(Grid(final), rule, topology, 1, first + gens, seed));
+		if(!saveSnapshot(save, out ? *out : grid, rle)){
+			std::fprintf(stderr, "%s: can't save snapshot %s\n", argv[0], save.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	if(!exported.empty() && !writePattern(exported, engine == "grid" ? grid.cells() : final, patternFormat(exported), rule.str())){
+		std::fprintf(stderr, "%s: can't export pattern %s\n", argv[0], exported.c_str());
+		return EXIT_FAILURE;
+	}
+	if(!profile.empty() && !Profile::write(profile)){
+		std::fprintf(stderr, "%s: can't write %s\n", argv[0], profile.c_str());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/**
+ * Conway's Game of Life simulation - cycle detection
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "cycles.h"
+#include <algorithm>
+
+/**************************************CYCLES CLASS**************************************/
+
+/**
+ * @brief Cycles
+ * @details Watch for periods of up to depth generations
+ * @param depth generations of whole grid hashes to keep
+ */
+Cycles::Cycles(size_t depth) : depth(std::max<size_t>(depth, 2)), cols(0), rows(0), wide(-1), tall(-1), whole(0),
+		gen(0), kept(0), candidate(0), matched(0), start(0){
+}
+/**
+ * @brief update
+ * @details Hash the tiles that changed since the last update and check the grid
+ * 			against the ones before it. A grid of a new size is hashed in full, and
+ * 			any generation other than the one after the last starts the watch over.
+ */
+void Cycles::update(Engine & engine){
+	const Grid & grid = engine.cells();
+	const Activity & act = engine.tiles();
+	unsigned long long now = engine.generation();
+	bool fresh = grid.width() != wide || grid.height() != tall;
+	if(fresh){
+		wide = grid.width();
+		tall = grid.height();
+		cols = act.across();
+		rows = act.down();
+		tiles.assign(static_cast<size_t>(cols) * rows, 0);
+		recent.assign(tiles.size() * TILE_HISTORY, 0);
+		whole = 0;
+	}
+	int bands = std::max(1, std::min(engine.workers().size(), rows));
+	std::vector<uint64_t> flips(bands, 0);
+	engine.workers().run(bands, [this, &grid, &act, fresh, bands, &flips](int part){
+		int ty0 = static_cast<int>(static_cast<long long>(rows) * part / bands);
+		int ty1 = static_cast<int>(static_cast<long long>(rows) * (part + 1) / bands);
+		for(int ty = ty0; ty < ty1; ty++){
+			for(int tx = 0; tx < cols; tx++){
+				if(!fresh && !act.changed(tx, ty))
+					continue;
+				uint64_t & mine = tiles[static_cast<size_t>(ty) * cols + tx];
+				uint64_t h = tileHash(grid, tx, ty);
+				flips[part] ^= mine ^ h;
+				mine = h;
+			}
+		}
+	});
+	for(int b = 0; b < bands; b++)
+		whole ^= flips[b];
+	if(fresh || kept == 0 || now != gen + 1)
+		restart();
+	gen = now;
+
+	for(size_t t = 0; t < tiles.size(); t++)
+		recent[t * TILE_HISTORY + now % TILE_HISTORY] = tiles[t];
+	uint64_t & slot = ring[now % depth];
+	if(kept >= depth){	//	the generation falling out of the ring
+		std::unordered_map<uint64_t, unsigned long long>::iterator old = seen.find(slot);
+		if(old != seen.end() && old->second == now - depth)
+			seen.erase(old);
+	}
+	if(candidate){
+		if(ring[(now - candidate) % depth] == whole)
+			matched++;
+		else
+			candidate = matched = 0;
+	}
+	if(!candidate){
+		std::unordered_map<uint64_t, unsigned long long>::iterator hit = seen.find(whole);
+		if(hit != seen.end()){
+			candidate = now - hit->second;
+			matched = 1;
+			start = hit->second;
+		}
+	}
+	slot = whole;
+	seen[whole] = now;
+	kept++;
+}
+/**
+ * @brief tilePeriod
+ * @details Shortest period a tile has kept to over its last TILE_HISTORY hashes,
+ * 			1 for a tile that hasn't changed, 0 if it isn't repeating (or hasn't
+ * 			been watched long enough to tell)
+ * @param tx tile column
+ * @param ty tile row
+ */
+unsigned long long Cycles::tilePeriod(int tx, int ty) const{
+	if(kept < TILE_HISTORY || tx < 0 || ty < 0 || tx >= cols || ty >= rows)
+		return 0;
+	const uint64_t * h = &recent[(static_cast<size_t>(ty) * cols + tx) * TILE_HISTORY];
+	for(unsigned p = 1; p <= TILE_HISTORY / 2; p++){
+		bool repeats = true;
+		for(unsigned j = 0; repeats && j + p < TILE_HISTORY; j++)
+			repeats = h[(gen - j) % TILE_HISTORY] == h[(gen - j - p) % TILE_HISTORY];
+		if(repeats)
+			return p;
+	}
+	return 0;
+}
+/**
+ * @brief restart
+ * @details Forget the history, keeping the tile hashes
+ */
+void Cycles::restart(){
+	ring.assign(depth, 0);
+	seen.clear();
+	kept = 0;
+	candidate = matched = start = 0;
+}
+/**
+ * @brief tileHash
+ * @details XOR of every word of a tile mixed with its place in the grid, so the
+ * 			same cells anywhere else hash differently
+ */
+uint64_t Cycles::tileHash(const Grid & grid, int tx, int ty) const{
+	size_t n = grid.words();
+	uint64_t tail = grid.tailMask();
+	int y0 = ty * TILE_ROWS;
+	int y1 = std::min(y0 + TILE_ROWS, grid.height());
+	size_t w0 = static_cast<size_t>(tx) * TILE_WORDS;
+	size_t w1 = std::min(w0 + TILE_WORDS, n);
+	uint64_t h = 0;
+	for(int y = y0; y < y1; y++){
+		const uint64_t * row = grid.row(y);
+		for(size_t i = w0; i < w1; i++)
+			h ^= Random::at(i + 1 < n ? row[i] : row[i] & tail, static_cast<uint64_t>(y) * n + i);
+	}
+	return h;
+}
+/**********************************End of CYCLES CLASS***********************************/
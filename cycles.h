@@ -0,0 +1,60 @@
+/**
+ * Conway's Game of Life simulation - cycle detection
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_CYCLES_H
+#define LIFE_CYCLES_H
+
+#include "engine.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief Cycles Object
+ * @details Watches an engine for the point where it starts repeating. The grid is
+ * 			hashed as the XOR of a keyed mix of every word and its place, kept per
+ * 			tile so only the tiles that changed are hashed again. The whole grid's
+ * 			hash for each of the last depth generations is kept, and a repeat of
+ * 			one is a candidate period; it only counts once every generation for a
+ * 			whole period has matched the one a period before, so a chance hash
+ * 			collision can't pass for a cycle. Each tile also keeps its last few
+ * 			hashes, enough to spot short local oscillators.
+ * 			update() must see every change to the cells: after each step, and
+ * 			after edits, which start the watch over. Tiles are hashed across the
+ * 			engine's workers.
+ */
+
+class Cycles{
+	public:
+		enum{ TILE_HISTORY = 16 };
+		explicit Cycles(size_t depth = 4096);
+		void update(Engine & engine);
+		uint64_t hash() const { return whole; }
+		unsigned long long period() const { return candidate && matched >= candidate ? candidate : 0; }
+		unsigned long long since() const { return start; }
+		unsigned long long tilePeriod(int tx, int ty) const;
+	private:
+		void restart();
+		uint64_t tileHash(const Grid & grid, int tx, int ty) const;
+		std::vector<uint64_t> tiles;		//	hash of each tile now
+		std::vector<uint64_t> recent;		//	each tile's last TILE_HISTORY hashes
+		std::vector<uint64_t> ring;			//	whole grid hash by generation % depth
+		std::unordered_map<uint64_t, unsigned long long> seen;	//	hash to latest generation in the ring
+		size_t depth;
+		int cols, rows;
+		int wide, tall;
+		uint64_t whole;
+		unsigned long long gen;
+		unsigned long long kept;			//	generations in the ring
+		unsigned long long candidate;		//	period being checked, 0 if none
+		unsigned long long matched;			//	generations in a row that matched it
+		unsigned long long start;			//	generation the cycle was first seen at
+};
+
+#endif
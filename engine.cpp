@@ -0,0 +1,1399 @@
+/**
+ * Conway's Game of Life simulation - engine
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#include "engine.h"
+#include "kernel.h"
+#include "profile.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+/***************************************GRID CLASS***************************************/
+
+/**
+ * @brief Grid
+ * @details Allocate a blank grid. The store is over-allocated by one cache line so
+ * 			the first row can be aligned to 64 bytes, plus one cache line of guard
+ * 			words either side of the halo rows for vector loads that run past them.
+ * @param wide number of cells across
+ * @param tall number of cells down
+ */
+Grid::Grid(int wide, int tall) : borrowed(0), wide(wide), tall(tall){
+	nwords = (static_cast<size_t>(wide) + 63) / 64;
+	pitch = pitchFor(wide);
+	store.assign(8 + imageWords(), 0);
+}
+/**
+ * @brief Grid
+ * @details Step cells held elsewhere. The image must be laid out as a grid of the
+ * 			same size lays out its own (see imageWords()), start on a 64 byte
+ * 			boundary and be writable; owner is held until the grid lets go of it.
+ * @param wide number of cells across
+ * @param tall number of cells down
+ * @param image front guard line of the cells
+ * @param owner whatever keeps image valid
+ */
+Grid::Grid(int wide, int tall, uint64_t * image, std::shared_ptr<void> owner) : owner(owner), borrowed(image),
+		wide(wide), tall(tall){
+	nwords = (static_cast<size_t>(wide) + 63) / 64;
+	pitch = pitchFor(wide);
+}
+/**
+ * @brief Grid copy
+ * @details The copy's store may sit at a different offset from a cache line, so the
+ * 			cells are copied from aligned base to aligned base rather than element
+ * 			for element.
+ * @param other grid to copy
+ */
+Grid::Grid(const Grid & other) : borrowed(0), wide(other.wide), tall(other.tall), nwords(other.nwords), pitch(other.pitch){
+	if(!other.image())	//	a moved-from grid has no cells to copy
+		return;
+	store.assign(8 + imageWords(), 0);
+	std::copy(other.base(), other.base() + imageWords(), base());
+}
+/**
+ * @brief Grid move
+ * @details Take over another grid's cells, leaving it 0x0 with no store and
+ * 			nothing borrowed
+ * @param other grid to take over
+ */
+Grid::Grid(Grid && other) noexcept : borrowed(0), wide(0), tall(0), nwords(0), pitch(0){
+	swap(other);
+}
+/**
+ * @brief operator=
+ * @details Move assignment, by swapping with the grid being moved from
+ * @param other grid to take over
+ */
+Grid & Grid::operator=(Grid && other) noexcept{
+	swap(other);
+	return *this;
+}
+/**
+ * @brief swap
+ * @details Trade cells with another grid in O(1); only the store pointers move
+ * @param other grid to trade with
+ */
+void Grid::swap(Grid & other) noexcept{
+	store.swap(other.store);
+	owner.swap(other.owner);
+	std::swap(borrowed, other.borrowed);
+	std::swap(wide, other.wide);
+	std::swap(tall, other.tall);
+	std::swap(nwords, other.nwords);
+	std::swap(pitch, other.pitch);
+}
+/**
+ * @brief base
+ * @details First 64 byte aligned word of the store, or the borrowed image. Worked
+ * 			out on every call so moved grids stay valid.
+ */
+uint64_t * Grid::base(){
+	if(borrowed)
+		return borrowed;
+	uintptr_t p = reinterpret_cast<uintptr_t>(store.data());
+	return reinterpret_cast<uint64_t *>((p + 63) & ~static_cast<uintptr_t>(63));
+}
+const uint64_t * Grid::base() const{
+	if(borrowed)
+		return borrowed;
+	uintptr_t p = reinterpret_cast<uintptr_t>(store.data());
+	return reinterpret_cast<const uint64_t *>((p + 63) & ~static_cast<uintptr_t>(63));
+}
+/**
+ * @brief row
+ * @details Pointer to the first word of a row. Rows -1 and tall are the halo rows,
+ * 			and word -1 of any row is the previous row's padding, so both are safe
+ * 			to read.
+ * @param y row index, -1 to tall
+ */
+uint64_t * Grid::row(int y){
+	return base() + 8 + static_cast<ptrdiff_t>(y + 1) * pitch;
+}
+const uint64_t * Grid::row(int y) const{
+	return base() + 8 + static_cast<ptrdiff_t>(y + 1) * pitch;
+}
+/**
+ * @brief bits
+ * @details The 64 cells of a row from x on, cell x in bit 0. Cells off either end
+ * 			of the row read as dead.
+ * @param y row index, 0 to tall-1
+ * @param x x-axis position of the first cell, any value
+ */
+uint64_t Grid::bits(int y, long long x) const{
+	const uint64_t * r = row(y);
+	long long n = static_cast<long long>(nwords);
+	long long w = x >= 0 ? x / 64 : -((63 - x) / 64);
+	int s = static_cast<int>(x - w * 64);
+	uint64_t lo = 0, hi = 0;
+	if(w >= 0 && w < n)
+		lo = w + 1 == n ? r[w] & tailMask() : r[w];
+	if(s && w + 1 >= 0 && w + 1 < n)
+		hi = w + 2 == n ? r[w+1] & tailMask() : r[w+1];
+	return s ? (lo >> s) | (hi << (64 - s)) : lo;
+}
+/**
+ * @brief tailMask
+ * @details Mask of the bits in the last word of a row that hold real cells
+ */
+uint64_t Grid::tailMask() const{
+	return (wide % 64) ? (~0ULL >> (64 - wide % 64)) : ~0ULL;
+}
+/**
+ * @brief get
+ * @details Read one cell. Anything one step outside the grid reads as dead.
+ * @param x x-axis position, -1 to wide
+ * @param y y-axis position, -1 to tall
+ */
+bool Grid::get(int x, int y) const{
+	return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+/**
+ * @brief set
+ * @details Write one cell. Must be inside the grid or the padding would come alive.
+ * @param x x-axis position
+ * @param y y-axis position
+ * @param alive new state of the cell
+ */
+void Grid::set(int x, int y, bool alive){
+	uint64_t bit = 1ULL << (x & 63);
+	if(alive)
+		row(y)[x >> 6] |= bit;
+	else
+		row(y)[x >> 6] &= ~bit;
+}
+/**
+ * @brief setRun
+ * @details Bring a row of cells to life a word at a time. Must be inside the grid.
+ * @param x x-axis position of the first cell
+ * @param y y-axis position
+ * @param n number of cells
+ */
+void Grid::setRun(int x, int y, int n){
+	uint64_t * r = row(y);
+	while(n > 0){
+		int s = x & 63, k = std::min(n, 64 - s);
+		r[x >> 6] |= (k == 64 ? ~0ULL : ((1ULL << k) - 1)) << s;
+		x += k;
+		n -= k;
+	}
+}
+/**
+ * @brief setEdge
+ * @details Write a cell of the halo: the rows -1 and tall, or the columns -1 and
+ * 			wide. Only the edge policies should do this, just before a step.
+ * @param x x-axis position, -1 to wide
+ * @param y y-axis position, -1 to tall
+ * @param alive new state of the cell
+ */
+void Grid::setEdge(int x, int y, bool alive){
+	uint64_t bit = 1ULL << (x & 63);
+	uint64_t & w = row(y)[x >> 6];
+	w = alive ? (w | bit) : (w & ~bit);
+}
+/**
+ * @brief clear
+ * @details Kill every cell
+ */
+void Grid::clear(){
+	std::fill(base(), base() + imageWords(), 0);
+}
+/***********************************End of GRID CLASS************************************/
+
+
+/**************************************STEP KERNEL***************************************/
+
+/**
+ * @brief stepBand
+ * @details Word-parallel generation step over a rectangle of words, sizeof(V)/8
+ * 			words at a time with a scalar finish for the rest of each row. The halo
+ * 			rows and padding words stand in for the neighbours beyond the edges (see
+ * 			the edge policies), and the spare bits of the last word are masked off.
+ * 			With COUNT it also fills in the rectangle's Stats from the words it has
+ * 			in registers anyway: running counts of the new cells, of the ones born
+ * 			and of the ones that died (C counts the vectors, T single words), and
+ * 			an OR of each column of words for the sides of the box. The top and
+ * 			bottom are found afterwards from the rows just written, still in cache,
+ * 			working in from the ends. The rectangle must be at most a tile wide.
+ * @return true if any cell in the rectangle changed
+ */
+template<class V, class R, bool COUNT, class C, class T> static LIFE_INLINE bool stepBand(const Grid & src, Grid & dst, const Rule & rule,
+		int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	const size_t lanes = sizeof(V) / sizeof(uint64_t);
+	size_t n = src.words();
+	if(n == 0)
+		return false;
+	uint64_t tail = src.tailMask();
+	size_t vend = (w1 == n) ? n - 1 : w1;	//	last word of a row is always done scalar, to be masked
+	V diff = V();
+	uint64_t rest = 0;
+	C counts;
+	T tails;
+	uint64_t cover[TILE_WORDS] = {};		//	OR of each column of words, for COUNT
+	for(int y = y0; y < y1; y++){
+		const uint64_t * up = src.row(y-1) - 1;
+		const uint64_t * mid = src.row(y) - 1;
+		const uint64_t * dn = src.row(y+1) - 1;
+		uint64_t * out = dst.row(y);
+		size_t i = w0;
+		for(; i + lanes <= vend; i += lanes){
+			V next = lifeWord<V, R>(up + i, mid + i, dn + i, rule);
+			V was = load<V>(mid + i + 1);
+			diff |= next ^ was;
+			std::memcpy(out + i, &next, sizeof(V));
+			if(COUNT){
+				counts.add(next, was);
+				V seen = load<V>(cover + (i - w0)) | next;
+				std::memcpy(cover + (i - w0), &seen, sizeof(V));
+			}
+		}
+		for(; i < w1; i++){
+			uint64_t next = lifeWord<uint64_t, R>(up + i, mid + i, dn + i, rule);
+			uint64_t was = mid[i+1];
+			if(i == n-1){
+				next &= tail;
+				was &= tail;
+			}
+			rest |= next ^ was;
+			out[i] = next;
+			if(COUNT){
+				tails.add(next, was);
+				cover[i - w0] |= next;
+			}
+		}
+	}
+	if(COUNT){
+		*stats = Stats();
+		counts.flush();
+		tails.flush();
+		stats->population = counts.live + tails.live;
+		stats->births = counts.born + tails.born;
+		stats->deaths = counts.died + tails.died;
+		if(stats->population){
+			size_t left = 0, right = w1 - w0 - 1;
+			while(!cover[left])
+				left++;
+			while(!cover[right])
+				right--;
+			int top = y0, bottom = y1 - 1;
+			while(blank(dst.row(top), w0, w1))
+				top++;
+			while(blank(dst.row(bottom), w0, w1))
+				bottom--;
+			stats->x0 = static_cast<int>((w0 + left) * 64) + lowest(cover[left]);
+			stats->x1 = static_cast<int>((w0 + right) * 64) + highest(cover[right]);
+			stats->y0 = top;
+			stats->y1 = bottom;
+		}
+	}
+	uint64_t lane[sizeof(V) / sizeof(uint64_t)];
+	std::memcpy(lane, &diff, sizeof(V));
+	for(size_t k = 0; k < lanes; k++)
+		rest |= lane[k];
+	return rest != 0;
+}
+/**
+ * @brief stepCounted
+ * @details Pick the counting or plain build of a kernel once per rectangle, so
+ * 			plain steps pay nothing for the counters
+ */
+template<class V, class R, class C, class T> static LIFE_INLINE bool stepCounted(const Grid & src, Grid & dst, const Rule & rule,
+		int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	if(stats)
+		return stepBand<V, R, true, C, T>(src, dst, rule, y0, y1, w0, w1, stats);
+	return stepBand<V, R, false, C, T>(src, dst, rule, y0, y1, w0, w1, 0);
+}
+
+template<class R> static bool stepRectScalar(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1,
+		Stats * stats){
+	return stepCounted<uint64_t, R, Census<uint64_t>, Census<uint64_t> >(src, dst, rule, y0, y1, w0, w1, stats);
+}
+#ifdef LIFE_SIMD
+template<class R> __attribute__((target("avx2,popcnt")))
+static bool stepRectAvx2(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	return stepCounted<u64x4, R, Census<u64x4>, WordCensus>(src, dst, rule, y0, y1, w0, w1, stats);
+}
+template<class R> __attribute__((target("avx512f,popcnt")))
+static bool stepRectAvx512(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	return stepCounted<u64x8, R, Census<u64x8>, WordCensus>(src, dst, rule, y0, y1, w0, w1, stats);
+}
+template<class R> __attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static bool stepRectAvx512Popcnt(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	return stepCounted<u64x8, R, LaneCensus<u64x8>, WordCensus>(src, dst, rule, y0, y1, w0, w1, stats);
+}
+#endif
+
+/**
+ * @brief isa
+ * @details Widest vector width this CPU can run, checked once with cpuid:
+ * 			3 for AVX-512 with its vector popcount, 2 for AVX-512, 1 for AVX2,
+ * 			0 for scalar only
+ */
+static int isa(){
+	static int width = -1;
+	if(width < 0){
+		width = 0;
+#ifdef LIFE_SIMD
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+			width = 3;
+		else if(__builtin_cpu_supports("avx512f"))
+			width = 2;
+		else if(__builtin_cpu_supports("avx2"))
+			width = 1;
+#endif
+	}
+	return width;
+}
+/**
+ * @brief cacheSize
+ * @details Bytes of level 2 or 3 cache, read from the system once; a modest
+ * 			256KB and 8MB where it won't say
+ */
+static size_t cacheSize(int level){
+	static size_t sizes[2] = { 0, 0 };
+	if(!sizes[0]){
+		sizes[0] = 256 << 10;
+		sizes[1] = 8 << 20;
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+		long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE), l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+		if(l2 > 0)
+			sizes[0] = static_cast<size_t>(l2);
+		if(l3 > 0)
+			sizes[1] = static_cast<size_t>(l3);
+#endif
+	}
+	return sizes[level == 2 ? 0 : 1];
+}
+/**
+ * @brief widest
+ * @details Widest kernel this CPU can run for rule R
+ */
+template<class R> static StepFn widest(){
+#ifdef LIFE_SIMD
+	if(isa() == 3)
+		return stepRectAvx512Popcnt<R>;
+	if(isa() == 2)
+		return stepRectAvx512<R>;
+	if(isa() == 1)
+		return stepRectAvx2<R>;
+#endif
+	return stepRectScalar<R>;
+}
+/**
+ * @brief kernelName
+ * @details Name of the instruction set stepRect() dispatches to on this machine
+ */
+const char * kernelName(){
+	static const char * names[] = { "scalar", "avx2", "avx512", "avx512+popcnt" };
+	return names[isa()];
+}
+/**
+ * @brief stepRect
+ * @details Advance a rectangle of words by one generation with the rule's kernel
+ * @param src current environment
+ * @param dst new environment, same size as src
+ * @param rule birth/survive rule
+ * @param y0 first row to compute
+ * @param y1 one past the last row to compute
+ * @param w0 first word of each row to compute
+ * @param w1 one past the last word to compute
+ * @param stats filled in with the rectangle's counts, at most a tile wide; 0 to skip them
+ * @return true if any cell in the rectangle changed
+ */
+bool stepRect(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats){
+	return rule.kernel(src, dst, rule, y0, y1, w0, w1, stats);
+}
+/**
+ * @brief stepRows
+ * @details Advance a band of full rows by one generation
+ * @param src current environment
+ * @param dst new environment, same size as src
+ * @param rule birth/survive rule
+ * @param y0 first row to compute
+ * @param y1 one past the last row to compute
+ */
+void stepRows(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1){
+	stepRect(src, dst, rule, y0, y1, 0, src.words());
+}
+/**********************************End of STEP KERNEL************************************/
+
+
+/***************************************RULE CLASS***************************************/
+
+/**
+ * @brief Rule
+ * @details Defaults to HighLife, B36/S23
+ */
+Rule::Rule(){
+	parse("B36/S23");
+}
+/**
+ * @brief parse
+ * @details Read a rulestring. Takes B3/S23 in either order and any case, the older
+ * 			survive/birth form 23/3, or one of the names conway, life, highlife,
+ * 			daynight and seeds. The rule is left alone if the text doesn't parse.
+ * @param text rulestring
+ * @return false if the text isn't a supported rule
+ */
+bool Rule::parse(const std::string & text){
+	std::string t;
+	for(size_t i = 0; i < text.size(); i++)
+		if(!std::isspace(static_cast<unsigned char>(text[i])))
+			t += static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+	if(t == "conway" || t == "life")
+		t = "b3/s23";
+	else if(t == "highlife")
+		t = "b36/s23";
+	else if(t == "daynight")
+		t = "b3678/s34678";
+	else if(t == "seeds")
+		t = "b2/s";
+	size_t slash = t.find('/');
+	if(slash == std::string::npos)
+		return false;
+	std::string a = t.substr(0, slash), b = t.substr(slash + 1);
+	if(!a.empty() && a[0] == 's')
+		std::swap(a, b);
+	bool tagged = !a.empty() && a[0] == 'b';
+	if(tagged){
+		if(b.empty() || b[0] != 's')
+			return false;
+		a.erase(0, 1);
+		b.erase(0, 1);
+	}
+	else
+		std::swap(a, b);		//	untagged form is survive/birth
+	unsigned masks[2] = { 0, 0 };
+	const std::string * parts[2] = { &a, &b };
+	for(int p = 0; p < 2; p++)
+		for(size_t i = 0; i < parts[p]->size(); i++){
+			char c = (*parts[p])[i];
+			if(c < '0' || c > '8')
+				return false;
+			masks[p] |= 1u << (c - '0');
+		}
+	if(masks[0] & 1)
+		return false;
+	birth = masks[0];
+	survive = masks[1];
+	terms = 0;
+	for(int k = 0; k <= 8; k++)
+		if(((birth | survive) >> k) & 1)
+			term[terms++] = k;
+	if(birth == 0x008 && survive == 0x00c){
+		kind = CONWAY;
+		kernel = widest<ConwayRule>();
+	}
+	else if(birth == 0x048 && survive == 0x00c){
+		kind = HIGHLIFE;
+		kernel = widest<HighLifeRule>();
+	}
+	else if(birth == 0x1c8 && survive == 0x1d8){
+		kind = DAYNIGHT;
+		kernel = widest<DayNightRule>();
+	}
+	else if(birth == 0x004 && survive == 0){
+		kind = SEEDS;
+		kernel = widest<SeedsRule>();
+	}
+	else{
+		kind = GENERIC;
+		kernel = widest<TableRule>();
+	}
+	return true;
+}
+/**
+ * @brief assign
+ * @details Set the rule from its birth and survive masks, as saved in a file
+ * @return false if the masks aren't a supported rule
+ */
+bool Rule::assign(unsigned birth, unsigned survive){
+	if(((birth | survive) >> 9) != 0)
+		return false;
+	Rule masks;
+	masks.birth = birth;
+	masks.survive = survive;
+	return parse(masks.str());
+}
+/**
+ * @brief str
+ * @details The rule as a B/S rulestring
+ */
+std::string Rule::str() const{
+	std::string t = "B";
+	for(int k = 0; k <= 8; k++)
+		if((birth >> k) & 1)
+			t += static_cast<char>('0' + k);
+	t += "/S";
+	for(int k = 0; k <= 8; k++)
+		if((survive >> k) & 1)
+			t += static_cast<char>('0' + k);
+	return t;
+}
+/***********************************End of RULE CLASS************************************/
+
+
+/***************************************POOL CLASS***************************************/
+
+/**
+ * @brief Pool
+ * @details Start the workers. The calling thread always takes part 0 of a job, so
+ * 			only threads-1 workers are spawned.
+ * @param threads total threads to step with, 0 for one per core
+ */
+Pool::Pool(int threads) : job(NULL), round(0), parts(0), pending(0), stop(false){
+	if(threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	if(threads <= 0)
+		threads = 1;
+	for(int i = 1; i < threads; i++)
+		workers.push_back(std::thread(&Pool::work, this, i));
+}
+/**
+ * @brief ~Pool
+ * @details Wake every worker with the stop flag set and wait for them to exit
+ */
+Pool::~Pool(){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stop = true;
+	}
+	wake.notify_all();
+	for(size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+/**
+ * @brief run
+ * @details Run job(0) to job(parts-1) across the pool and wait for all of them
+ * @param parts number of pieces to split the job into, capped at the pool size
+ * @param job work for one piece, called with the piece number
+ */
+void Pool::run(int parts, const std::function<void(int)> & job){
+	parts = std::max(1, std::min(parts, size()));
+	if(parts == 1){
+		job(0);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		this->job = &job;
+		this->parts = parts;
+		pending = parts - 1;
+		round++;
+	}
+	wake.notify_all();
+	job(0);
+	std::unique_lock<std::mutex> guard(lock);
+	while(pending > 0)
+		done.wait(guard);
+	this->job = NULL;
+}
+/**
+ * @brief work
+ * @details Worker loop. Sleeps until a new round is posted, runs its piece if the
+ * 			job has one for it, then reports back.
+ * @param part piece number this worker always takes
+ */
+void Pool::work(int part){
+	unsigned long long seen = 0;
+	for(;;){
+		const std::function<void(int)> * fn;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while(!stop && round == seen)
+				wake.wait(guard);
+			if(stop)
+				return;
+			seen = round;
+			if(part >= parts)
+				continue;
+			fn = job;
+		}
+		(*fn)(part);
+		std::lock_guard<std::mutex> guard(lock);
+		if(--pending == 0)
+			done.notify_one();
+	}
+}
+/***********************************End of POOL CLASS************************************/
+
+
+/*************************************ACTIVITY CLASS*************************************/
+
+/**
+ * @brief add
+ * @details Fold another tile's counts in, growing the box to cover both
+ */
+void Stats::add(const Stats & other){
+	population += other.population;
+	births += other.births;
+	deaths += other.deaths;
+	if(other.x1 < other.x0)
+		return;
+	if(x1 < x0){
+		x0 = other.x0;
+		y0 = other.y0;
+		x1 = other.x1;
+		y1 = other.y1;
+		return;
+	}
+	x0 = std::min(x0, other.x0);
+	y0 = std::min(y0, other.y0);
+	x1 = std::max(x1, other.x1);
+	y1 = std::max(y1, other.y1);
+}
+
+/**
+ * @brief Activity
+ * @details Tile flags for a wide x tall grid, every tile starting out changed so
+ * 			the first generations are stepped in full.
+ * @param wide number of cells across
+ * @param tall number of cells down
+ */
+Activity::Activity(int wide, int tall){
+	cols = static_cast<int>(((static_cast<size_t>(wide) + 63) / 64 + TILE_WORDS - 1) / TILE_WORDS);
+	rows = (tall + TILE_ROWS - 1) / TILE_ROWS;
+	last.assign(static_cast<size_t>(cols + 2) * (rows + 2), 0);
+	next = last;
+	seen = last;
+	touchAll();
+}
+/**
+ * @brief touch
+ * @details Flag the tile holding a cell that was edited outside of a step
+ * @param x x-axis position
+ * @param y y-axis position
+ */
+void Activity::touch(int x, int y){
+	last[at(x / (64 * TILE_WORDS), y / TILE_ROWS)] = 1;
+	seen[at(x / (64 * TILE_WORDS), y / TILE_ROWS)] = 1;
+}
+/**
+ * @brief touchAll
+ * @details Flag every tile, after the whole grid was rewritten
+ */
+void Activity::touchAll(){
+	for(int ty = 0; ty < rows; ty++)
+		for(int tx = 0; tx < cols; tx++)
+			last[at(tx, ty)] = seen[at(tx, ty)] = 1;
+}
+/**
+ * @brief active
+ * @details Whether a tile has to be stepped this generation
+ * @param tx tile column
+ * @param ty tile row
+ */
+bool Activity::active(int tx, int ty) const{
+	const unsigned char * above = &last[at(tx - 1, ty - 1)];
+	const unsigned char * here = &last[at(tx - 1, ty)];
+	const unsigned char * below = &last[at(tx - 1, ty + 1)];
+	return (above[0] | above[1] | above[2] | here[0] | here[1] | here[2] | below[0] | below[1] | below[2]) != 0;
+}
+/**
+ * @brief mark
+ * @details Record whether a tile changed in the generation being stepped
+ * @param tx tile column
+ * @param ty tile row
+ * @param changed true if any of its cells changed
+ */
+void Activity::mark(int tx, int ty, bool changed){
+	next[at(tx, ty)] = changed;
+}
+/**
+ * @brief flip
+ * @details Make the flags just marked the ones active() reads, and add them to
+ * 			the changes gathered since clean()
+ */
+void Activity::flip(){
+	last.swap(next);
+	for(size_t i = 0; i < seen.size(); i++)
+		seen[i] |= last[i];
+}
+/**
+ * @brief clean
+ * @details Forget the changes gathered so far, once they have been read
+ */
+void Activity::clean(){
+	std::fill(seen.begin(), seen.end(), 0);
+}
+/**
+ * @brief wrap
+ * @details For topologies where cells beyond one edge come from the far edge: if
+ * 			any edge tile changed, treat the whole blank border as changed so every
+ * 			edge tile gets stepped. Conservative, but only edge tiles pay for it.
+ */
+void Activity::wrap(){
+	unsigned char any = 0;
+	for(int tx = 0; tx < cols; tx++)
+		any |= last[at(tx, 0)] | last[at(tx, rows - 1)];
+	for(int ty = 0; ty < rows; ty++)
+		any |= last[at(0, ty)] | last[at(cols - 1, ty)];
+	for(int tx = -1; tx <= cols; tx++)
+		last[at(tx, -1)] = last[at(tx, rows)] = any;
+	for(int ty = 0; ty < rows; ty++)
+		last[at(-1, ty)] = last[at(cols, ty)] = any;
+}
+/**
+ * @brief count
+ * @details Start or stop keeping Stats per tile. Starting flags every tile, so
+ * 			the next step works them all out.
+ */
+void Activity::count(bool on){
+	if(on == counting())
+		return;
+	if(on){
+		counts.assign(static_cast<size_t>(cols) * rows, Stats());
+		touchAll();
+	}
+	else
+		std::vector<Stats>().swap(counts);
+}
+/**
+ * @brief total
+ * @details The tiles' Stats added up
+ */
+Stats Activity::total() const{
+	Stats sum;
+	for(size_t t = 0; t < counts.size(); t++)
+		sum.add(counts[t]);
+	return sum;
+}
+/**
+ * @brief stepTiles
+ * @details Advance the tiles of rows ty0 to ty1-1 that are active, skipping the
+ * 			rest. A skipped tile and its neighbours did not change last generation,
+ * 			so dst, which holds the generation before src, already matches src
+ * 			there. Every tile of the rows gets marked for the next generation,
+ * 			and has its Stats brought up to date if act is counting.
+ * @param src current environment
+ * @param dst new environment, holding the generation before src
+ * @param act tile flags for src
+ * @param rule birth/survive rule
+ * @param ty0 first tile row
+ * @param ty1 one past the last tile row
+ * @return number of tiles skipped
+ */
+size_t stepTiles(const Grid & src, Grid & dst, Activity & act, const Rule & rule, int ty0, int ty1){
+	size_t skipped = 0;
+	size_t n = src.words();
+	for(int ty = ty0; ty < ty1; ty++){
+		int y0 = ty * TILE_ROWS;
+		int y1 = std::min(y0 + TILE_ROWS, src.height());
+		for(int tx = 0; tx < act.across(); tx++){
+			Stats * stats = act.stats(tx, ty);
+			if(!act.active(tx, ty)){
+				act.mark(tx, ty, false);
+				if(stats)
+					stats->births = stats->deaths = 0;
+				skipped++;
+				continue;
+			}
+			size_t w0 = static_cast<size_t>(tx) * TILE_WORDS;
+			size_t w1 = std::min(w0 + TILE_WORDS, n);
+			act.mark(tx, ty, stepRect(src, dst, rule, y0, y1, w0, w1, stats));
+		}
+	}
+	return skipped;
+}
+/*********************************End of ACTIVITY CLASS**********************************/
+
+
+/****************************************TOPOLOGY****************************************/
+
+/**
+ * @brief sides
+ * @details Fill the columns -1 and wide of every row, halo rows included, from
+ * 			the far side of the same row
+ */
+static void wrapSides(Grid & grid){
+	int w = grid.width();
+	for(int y = -1; y <= grid.height(); y++){
+		grid.setEdge(-1, y, grid.get(w - 1, y));
+		grid.setEdge(w, y, grid.get(0, y));
+	}
+}
+/**
+ * @brief fill
+ * @details Torus: top wraps to bottom, left wraps to right
+ */
+void Torus::fill(Grid & grid){
+	int t = grid.height();
+	if(grid.width() == 0 || t == 0)
+		return;
+	std::memcpy(grid.row(-1), grid.row(t - 1), grid.words() * sizeof(uint64_t));
+	std::memcpy(grid.row(t), grid.row(0), grid.words() * sizeof(uint64_t));
+	sides(grid);
+}
+void Torus::sides(Grid & grid){
+	wrapSides(grid);
+}
+/**
+ * @brief beyond
+ * @details Torus: the rows repeat every tall
+ */
+int Torus::beyond(long long y, int tall, bool & flip){
+	long long r = y % tall;
+	flip = false;
+	return static_cast<int>(r < 0 ? r + tall : r);
+}
+/**
+ * @brief fill
+ * @details Klein bottle: left wraps to right, top wraps to bottom mirrored left
+ * 			to right
+ */
+void KleinBottle::fill(Grid & grid){
+	int w = grid.width(), t = grid.height();
+	if(w == 0 || t == 0)
+		return;
+	for(int x = 0; x < w; x++){
+		grid.setEdge(x, -1, grid.get(w - 1 - x, t - 1));
+		grid.setEdge(x, t, grid.get(w - 1 - x, 0));
+	}
+	sides(grid);
+}
+void KleinBottle::sides(Grid & grid){
+	wrapSides(grid);
+}
+/**
+ * @brief beyond
+ * @details Klein bottle: the rows repeat every tall, turned round each time
+ */
+int KleinBottle::beyond(long long y, int tall, bool & flip){
+	long long q = y >= 0 ? y / tall : -((tall - 1 - y) / tall);	//	rounded down
+	flip = (q & 1) != 0;
+	return static_cast<int>(y - q * tall);
+}
+/**
+ * @brief fill
+ * @details Mirror: each edge row and column is reflected back across the edge
+ */
+void Mirror::fill(Grid & grid){
+	int w = grid.width(), t = grid.height();
+	if(w == 0 || t == 0)
+		return;
+	std::memcpy(grid.row(-1), grid.row(0), grid.words() * sizeof(uint64_t));
+	std::memcpy(grid.row(t), grid.row(t - 1), grid.words() * sizeof(uint64_t));
+	sides(grid);
+}
+void Mirror::sides(Grid & grid){
+	int w = grid.width();
+	for(int y = -1; y <= grid.height(); y++){
+		grid.setEdge(-1, y, grid.get(0, y));
+		grid.setEdge(w, y, grid.get(w - 1, y));
+	}
+}
+/**
+ * @brief beyond
+ * @details Mirror: the grid reflected in each edge, so the rows go back and
+ * 			forth every 2 tall. Reflecting is a symmetry of every rule, so the
+ * 			reflected rows stay the reflection of the grid as they are stepped.
+ */
+int Mirror::beyond(long long y, int tall, bool & flip){
+	long long r = y % (2LL * tall);
+	if(r < 0)
+		r += 2LL * tall;
+	flip = false;
+	return static_cast<int>(r < tall ? r : 2LL * tall - 1 - r);
+}
+/**
+ * @brief stepGrid
+ * @details One generation of src into dst. The edge policy fills src's halo,
+ * 			then the rows of tiles are split into bands stepped across the pool;
+ * 			neighbouring bands read each other's edge rows straight out of src.
+ * 			dst must hold the generation before src (see stepTiles()).
+ * @param src current environment
+ * @param dst previous environment, overwritten with the next one
+ * @param act tile flags for src, flipped for the next generation
+ * @param rule birth/survive rule
+ * @param pool threads to step on
+ * @return fraction of tiles skipped
+ */
+template<class Edge> double stepGrid(Grid & src, Grid & dst, Activity & act, const Rule & rule, Pool & pool){
+	Edge::fill(src);
+	if(Edge::wraps)
+		act.wrap();
+	int bands = std::max(1, std::min(pool.size(), act.down()));
+	std::vector<size_t> skipped(bands, 0);
+	pool.run(bands, [&src, &dst, &act, &rule, bands, &skipped](int part){
+		LIFE_TIME(BAND);
+		int ty0 = static_cast<int>(static_cast<long long>(act.down()) * part / bands);
+		int ty1 = static_cast<int>(static_cast<long long>(act.down()) * (part + 1) / bands);
+		skipped[part] = stepTiles(src, dst, act, rule, ty0, ty1);
+	});
+	act.flip();
+	size_t total = static_cast<size_t>(act.across()) * act.down();
+	return total ? static_cast<double>(std::accumulate(skipped.begin(), skipped.end(), size_t(0))) / total : 0;
+}
+/**
+ * @brief pickStepper
+ * @details Step function for a topology number, as in the topology default
+ */
+Stepper pickStepper(int topology){
+	switch(topology){
+		case 1:
+			return stepGrid<Torus>;
+		case 2:
+			return stepGrid<KleinBottle>;
+		case 3:
+			return stepGrid<Mirror>;
+		default:
+			return stepGrid<DeadBorder>;
+	}
+}
+/**
+ * @brief bandRows
+ * @details Rows of a grid stepBlock() does at once for depth generations: as many
+ * 			whole tiles as leave the band and its 2 depth extra rows, in both
+ * 			buffers, in half a core's L2, and at least one
+ */
+static int bandRows(const Grid & grid, int depth){
+	long long fit = static_cast<long long>(cacheSize(2) / 4 / (grid.stride() * sizeof(uint64_t)));
+	long long band = (fit - 2LL * depth) / TILE_ROWS * TILE_ROWS;
+	return static_cast<int>(std::max<long long>(band, TILE_ROWS));
+}
+/**
+ * @brief reverseRow
+ * @details Copy a packed row turned round left to right
+ */
+static void reverseRow(const uint64_t * from, uint64_t * to, size_t n, int wide){
+	std::fill(to, to + n, 0);
+	for(size_t i = 0; i < n; i++){
+		for(uint64_t w = from[i]; w; w &= w - 1){
+			int x = wide - 1 - static_cast<int>(i * 64 + lowest(w));
+			if(x >= 0)
+				to[x >> 6] |= 1ULL << (x & 63);
+		}
+	}
+}
+/**
+ * @brief stepBlock
+ * @details gens generations of src into dst in one pass over memory. The grid is
+ * 			cut into bands of whole tile rows, shared out across the pool. Each
+ * 			band is copied, with gens rows more above and below, into a buffer
+ * 			small enough to stay in the worker's cache and stepped there gens
+ * 			times; the rows that can't be right any more drop off each end one a
+ * 			generation, until only the band is left to be written to dst. Rows
+ * 			past the top and bottom are copied in from wherever the topology says
+ * 			they come from, or left blank and never stepped at a dead edge, so
+ * 			each generation in the buffer is the one single steps would give.
+ * 			Nothing is skipped. A tile is marked if it changed in the last
+ * 			generation or differs from src at all: dst is left holding src's
+ * 			generation, so only tiles where that matches can be skipped next step.
+ * @param src current environment
+ * @param dst previous environment, overwritten with the one gens on
+ * @param act tile flags, marked and flipped for the next generation
+ * @param rule birth/survive rule
+ * @param pool threads to step on
+ * @param scratch band buffers, two per part, made to size if they aren't
+ * @param gens generations to step, at least 1
+ * @param band rows in a band, a whole number of tiles
+ * @return share of tiles the next single step would skip
+ */
+template<class Edge> double stepBlock(Grid & src, Grid & dst, Activity & act, const Rule & rule, Pool & pool,
+		std::vector<Grid> & scratch, int gens, int band){
+	int wide = src.width(), tall = src.height();
+	size_t n = src.words();
+	if(wide == 0 || tall == 0)
+		return 0;
+	bool flip = false;
+	bool dead = Edge::beyond(-1, tall, flip) < 0;	//	rows past the edges are blank, not copies
+	int bands = (tall + band - 1) / band;
+	int parts = std::max(1, std::min(pool.size(), bands));
+	int high = band + 2 * gens;
+	if(scratch.size() < static_cast<size_t>(2 * parts) || scratch[0].width() != wide || scratch[0].height() < high){
+		scratch.clear();
+		scratch.reserve(2 * parts);
+		for(int i = 0; i < 2 * parts; i++)
+			scratch.push_back(Grid(wide, high));
+	}
+	uint64_t tail = src.tailMask();
+	pool.run(parts, [&, dead, bands, parts, n, tail](int part){
+		LIFE_TIME(BAND);
+		Grid & cur = scratch[2 * part];
+		Grid & next = scratch[2 * part + 1];
+		int b0 = static_cast<int>(static_cast<long long>(bands) * part / parts);
+		int b1 = static_cast<int>(static_cast<long long>(bands) * (part + 1) / parts);
+		for(int b = b0; b < b1; b++){
+			int y0 = b * band, y1 = std::min(y0 + band, tall);
+			int top = y0 - gens;			//	row of the grid in the buffer's row 0
+			int rows = y1 - y0 + 2 * gens;
+			for(int r = 0; r < rows; r++){
+				int y = top + r;
+				bool turned = false;
+				int from = (y >= 0 && y < tall) ? y : Edge::beyond(y, tall, turned);
+				if(from < 0){
+					std::memset(cur.row(r), 0, n * sizeof(uint64_t));
+					std::memset(next.row(r), 0, n * sizeof(uint64_t));
+				}
+				else if(turned)
+					reverseRow(src.row(from), cur.row(r), n, wide);
+				else
+					std::memcpy(cur.row(r), src.row(from), n * sizeof(uint64_t));
+			}
+			for(int j = 1; j < gens; j++){
+				int r0 = j, r1 = rows - j;
+				if(dead){
+					r0 = std::max(r0, -top);
+					r1 = std::min(r1, tall - top);
+				}
+				Edge::sides(cur);
+				stepRect(cur, next, rule, r0, r1, 0, n);
+				cur.swap(next);
+			}
+			//	The last generation goes tile by tile, for the flags
+			Edge::sides(cur);
+			for(int ty = y0 / TILE_ROWS; ty * TILE_ROWS < y1; ty++){
+				int t0 = ty * TILE_ROWS, t1 = std::min(t0 + TILE_ROWS, y1);
+				for(int tx = 0; tx < act.across(); tx++){
+					size_t w0 = static_cast<size_t>(tx) * TILE_WORDS;
+					size_t w1 = std::min(w0 + TILE_WORDS, n);
+					bool changed = stepRect(cur, next, rule, t0 - top, t1 - top, w0, w1);
+					uint64_t moved = 0;
+					for(int y = t0; y < t1; y++){
+						const uint64_t * was = src.row(y);
+						const uint64_t * now = next.row(y - top);
+						uint64_t * out = dst.row(y);
+						for(size_t i = w0; i < w1; i++){
+							moved |= (now[i] ^ was[i]) & (i + 1 < n ? ~0ULL : tail);
+							out[i] = now[i];
+						}
+					}
+					act.mark(tx, ty, changed || moved != 0);
+				}
+			}
+		}
+	});
+	act.flip();
+	if(Edge::wraps)
+		act.wrap();
+	size_t idle = 0, total = static_cast<size_t>(act.across()) * act.down();
+	for(int ty = 0; ty < act.down(); ty++)
+		for(int tx = 0; tx < act.across(); tx++)
+			idle += !act.active(tx, ty);
+	return total ? static_cast<double>(idle) / total : 0;
+}
+/**
+ * @brief pickBlocker
+ * @details Block step function for a topology number
+ */
+Blocker pickBlocker(int topology){
+	switch(topology){
+		case 1:
+			return stepBlock<Torus>;
+		case 2:
+			return stepBlock<KleinBottle>;
+		case 3:
+			return stepBlock<Mirror>;
+		default:
+			return stepBlock<DeadBorder>;
+	}
+}
+/************************************End of TOPOLOGY*************************************/
+
+
+/**************************************ENGINE CLASS**************************************/
+
+/**
+ * @brief Engine
+ * @details Blank universe at generation 0
+ * @param wide number of cells across
+ * @param tall number of cells down
+ * @param rule birth/survive rule
+ * @param topology edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+ * @param threads stepping threads, 0 for one per core
+ */
+Engine::Engine(int wide, int tall, const Rule & rule, int topology, int threads)
+		: vect(wide, tall), tmp(wide, tall), act(wide, tall), rules(rule), stepper(pickStepper(topology)),
+		blocker(pickBlocker(topology)), pool(threads), edges(topology), seeded(0), gens(0), skipped(0), blocking(0){
+}
+/**
+ * @brief Engine
+ * @details Carry on from cells saved earlier, such as a snapshot
+ * @param cells grid to take over
+ * @param rule birth/survive rule
+ * @param topology edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+ * @param threads stepping threads, 0 for one per core
+ * @param generation generation the cells are at
+ * @param seed seed the run was filled from
+ */
+Engine::Engine(Grid && cells, const Rule & rule, int topology, int threads, unsigned long long generation, unsigned seed)
+		: vect(std::move(cells)), tmp(vect.width(), vect.height()), act(vect.width(), vect.height()), rules(rule),
+		stepper(pickStepper(topology)), blocker(pickBlocker(topology)), pool(threads), edges(topology), seeded(seed),
+		gens(generation), skipped(0), blocking(0){
+}
+/**
+ * @brief step
+ * @details Advance one generation. vect and tmp are a double buffer: the kernel
+ * 			rewrites every cell of tmp it doesn't skip, so whatever generation it
+ * 			held before (and any edits made to vect since) can't leak through, and
+ * 			the two are flipped rather than copied.
+ */
+void Engine::step(){
+	LIFE_TIME(STEP);
+	skipped = stepper(vect, tmp, act, rules, pool);
+	vect.swap(tmp);	//	New environment becomes current, old one is reused next time
+	gens++;
+}
+/**
+ * @brief run
+ * @details Advance a number of generations, blockDepth() of them per pass over
+ * 			memory where that is more than 1 (see stepBlock()). Single steps take
+ * 			over while most tiles are settled, since they skip those and a pass
+ * 			doesn't, and while counting, which needs every generation.
+ */
+void Engine::run(unsigned long long gens){
+	int depth = blockDepth();
+	int band = depth > 1 ? bandRows(vect, depth) : 0;
+	double settled = skipped;
+	while(gens > 0){
+		if(depth > 1 && gens > 1 && settled <= BLOCK_IDLE && !act.counting()){
+			int k = static_cast<int>(std::min<unsigned long long>(depth, gens));
+			settled = blocker(vect, tmp, act, rules, pool, scratch, k, band);
+			vect.swap(tmp);
+			this->gens += k;
+			gens -= k;
+			skipped = 0;
+			continue;
+		}
+		step();
+		settled = skipped;
+		gens--;
+	}
+}
+/**
+ * @brief blockDepth
+ * @details Generations run() steps per pass over memory. Unless set with block(),
+ * 			1 for a grid whose double buffer fits in the last level cache, where
+ * 			memory isn't what holds a step up; otherwise as many as leave a band
+ * 			four times as tall as the rows stepped above and below it for nothing,
+ * 			with both band buffers in half a core's L2.
+ */
+int Engine::blockDepth() const{
+	if(blocking > 0)
+		return blocking;
+	if(2 * vect.imageWords() * sizeof(uint64_t) <= cacheSize(3))
+		return 1;
+	size_t fit = cacheSize(2) / 4 / (vect.stride() * sizeof(uint64_t));
+	int depth = static_cast<int>(std::min<size_t>(fit / 6, BLOCK_GENS));
+	return depth > 1 ? depth : 1;
+}
+/**
+ * @brief advance
+ * @details Count generations as stepped without stepping them. Only right for a
+ * 			grid known to repeat every so many generations (see Cycles), when gens
+ * 			is a whole number of periods.
+ */
+void Engine::advance(unsigned long long gens){
+	this->gens += gens;
+}
+/**
+ * @brief set
+ * @details Edit one cell between generations. Must be inside the grid.
+ * @param x x-axis position
+ * @param y y-axis position
+ * @param alive new state of the cell
+ */
+void Engine::set(int x, int y, bool alive){
+	vect.set(x, y, alive);
+	act.touch(x, y);
+}
+/**
+ * @brief setRun
+ * @details Bring a row of cells to life, such as a run out of a pattern file. The
+ * 			part off the grid is dropped.
+ * @param x x-axis position of the first cell
+ * @param y y-axis position
+ * @param n number of cells
+ */
+void Engine::setRun(long long x, long long y, long long n){
+	long long x0 = std::max(x, 0LL), x1 = std::min(x + n, static_cast<long long>(vect.width()));
+	if(y < 0 || y >= vect.height() || x0 >= x1)
+		return;
+	vect.setRun(static_cast<int>(x0), static_cast<int>(y), static_cast<int>(x1 - x0));
+	for(long long t = x0; t < x1; t = (t / (64 * TILE_WORDS) + 1) * (64 * TILE_WORDS))
+		act.touch(static_cast<int>(t), static_cast<int>(y));
+}
+/**
+ * @brief setRow
+ * @details Overwrite a whole row of cells, such as one sent over from another
+ * 			process. Only the tiles whose part of the row changed are flagged.
+ * @param y row to write
+ * @param words the row's cells, packed as in a Grid row
+ */
+void Engine::setRow(int y, const uint64_t * words){
+	size_t n = vect.words();
+	uint64_t * row = vect.row(y);
+	for(size_t w0 = 0; w0 < n; w0 += TILE_WORDS){
+		size_t w1 = std::min(w0 + TILE_WORDS, n);
+		uint64_t flips = 0;
+		for(size_t i = w0; i < w1; i++){
+			uint64_t w = i + 1 < n ? words[i] : words[i] & vect.tailMask();
+			flips |= row[i] ^ w;
+			row[i] = w;
+		}
+		if(flips)
+			act.touch(static_cast<int>(w0 * 64), y);
+	}
+}
+/**
+ * @brief fill
+ * @details Fill environment with random occurrences of cells. Word i of row y is
+ * 			drawn from counter y * words + i of the seed, so bands of rows fill
+ * 			in parallel and the cells are the same whatever the thread count.
+ * 			Densities are kept to 16 bits: each draw takes one bit of the density
+ * 			from the lowest set one up, OR-ing a fresh word in for a 1 and AND-ing
+ * 			one in for a 0, which halves the odds then adds the bit. 50% is one
+ * 			draw per 64 cells, 1/65536 at most sixteen.
+ * @param seed seed for the generator
+ * @param density chance of each cell being alive, 0 to 1
+ * @param origin row of a larger grid this grid's row 0 stands for, so a slab of
+ * 			it gets the same cells the whole grid would
+ */
+void Engine::fill(unsigned seed, double density, long long origin){
+	seeded = seed;
+	long long odds = std::llround(std::min(std::max(density, 0.0), 1.0) * 65536);
+	int low = 0;
+	while(odds > 0 && odds < 65536 && !((odds >> low) & 1))
+		low++;
+	Grid & grid = vect;
+	size_t n = grid.words();
+	int tall = grid.height();
+	int parts = std::max(1, std::min(pool.size(), tall));
+	pool.run(parts, [&grid, n, tall, parts, seed, odds, low, origin](int part){
+		int y0 = static_cast<int>(static_cast<long long>(tall) * part / parts);
+		int y1 = static_cast<int>(static_cast<long long>(tall) * (part + 1) / parts);
+		for(int y = y0; y < y1; y++){
+			uint64_t * row = grid.row(y);
+			for(size_t i = 0; i < n; i++){
+				uint64_t counter = static_cast<uint64_t>(y + origin) * n + i;
+				uint64_t w = odds >= 65536 ? ~0ULL : 0;
+				for(int k = low; odds > 0 && odds < 65536 && k < 16; k++){
+					uint64_t x = Random::at(seed + static_cast<uint64_t>(k) * 0xd1b54a32d192ed03ULL, counter);
+					w = k == low ? x : ((odds >> k) & 1) ? (w | x) : (w & x);
+				}
+				row[i] = w;
+			}
+			if(n)
+				row[n-1] &= grid.tailMask();
+		}
+	});
+	act.touchAll();
+}
+/**
+ * @brief clear
+ * @details Kill every cell
+ */
+void Engine::clear(){
+	vect.clear();
+	act.touchAll();
+}
+/**
+ * @brief population
+ * @details Number of live cells
+ */
+uint64_t Engine::population() const{
+	uint64_t pop = 0;
+	size_t n = vect.words();
+	for(int y = 0; y < vect.height(); y++){
+		const uint64_t * row = vect.row(y);
+		for(size_t i = 0; i + 1 < n; i++)
+			pop += popcount(row[i]);
+		if(n)
+			pop += popcount(row[n-1] & vect.tailMask());
+	}
+	return pop;
+}
+/**********************************End of ENGINE CLASS***********************************/
+
+/**************************************MIPMAP CLASS**************************************/
+
+Mipmap::Mipmap() : wide(0), tall(0){
+}
+/**
+ * @brief update
+ * @details Catch up with the engine's grid. A new grid size builds every level
+ * 			from scratch; otherwise only the blocks over changed tiles are redone,
+ * 			so the cost follows the activity rather than the size of the universe.
+ */
+void Mipmap::update(Engine & engine){
+	const Grid & grid = engine.cells();
+	const Activity & act = engine.tiles();
+	if(grid.width() != wide || grid.height() != tall){
+		wide = grid.width();
+		tall = grid.height();
+		maps.clear();
+		for(int k = 1; wide && tall && (width(k - 1) > 1 || height(k - 1) > 1); k++)
+			maps.push_back(std::vector<unsigned char>(static_cast<size_t>(width(k)) * height(k), 0));
+		redo(grid, 0, 0, wide, tall);
+	}
+	else{
+		for(int ty = 0; ty < act.down(); ty++){
+			for(int tx = 0; tx < act.across(); tx++){
+				if(act.dirty(tx, ty))
+					redo(grid, tx * 64 * TILE_WORDS, ty * TILE_ROWS,
+							std::min(wide, (tx + 1) * 64 * TILE_WORDS), std::min(tall, (ty + 1) * TILE_ROWS));
+			}
+		}
+	}
+	engine.clean();
+}
+/**
+ * @brief redo
+ * @details Recompute every level over the cells x0 to x1-1, y0 to y1-1. Level 1
+ * 			counts the four cells of each block straight from the bit rows, and
+ * 			each level after that averages four blocks of the one below.
+ */
+void Mipmap::redo(const Grid & grid, int x0, int y0, int x1, int y1){
+	if(maps.empty() || x0 >= x1 || y0 >= y1)
+		return;
+	uint64_t tail = grid.tailMask();
+	size_t n = grid.words();
+	int bx0 = x0 >> 1, bx1 = (x1 + 1) >> 1;
+	int by0 = y0 >> 1, by1 = (y1 + 1) >> 1;
+	for(int by = by0; by < by1; by++){
+		const uint64_t * r0 = grid.row(2 * by);
+		const uint64_t * r1 = 2 * by + 1 < tall ? grid.row(2 * by + 1) : 0;
+		unsigned char * out = &maps[0][static_cast<size_t>(by) * width(1)];
+		for(int bx = bx0; bx < bx1; bx++){
+			size_t i = static_cast<size_t>(bx) >> 5;
+			int s = (bx & 31) * 2;
+			uint64_t m = i + 1 == n ? tail : ~0ULL;
+			int pop = popcount((r0[i] & m) >> s & 3) + (r1 ? popcount((r1[i] & m) >> s & 3) : 0);
+			out[bx] = static_cast<unsigned char>((pop * 255 + 3) / 4);
+		}
+	}
+	for(int k = 2; k <= levels(); k++){
+		bx0 >>= 1; by0 >>= 1;
+		bx1 = (bx1 + 1) >> 1; by1 = (by1 + 1) >> 1;
+		const std::vector<unsigned char> & in = maps[k-2];
+		std::vector<unsigned char> & out = maps[k-1];
+		int iw = width(k - 1), ih = height(k - 1), ow = width(k);
+		for(int by = by0; by < by1; by++){
+			for(int bx = bx0; bx < bx1; bx++){
+				int sum = 0;
+				for(int j = 0; j < 2; j++){
+					for(int i = 0; i < 2; i++){
+						if(2 * bx + i < iw && 2 * by + j < ih)
+							sum += in[static_cast<size_t>(2 * by + j) * iw + 2 * bx + i];
+					}
+				}
+				out[static_cast<size_t>(by) * ow + bx] = static_cast<unsigned char>((sum + 3) / 4);
+			}
+		}
+	}
+}
+/**********************************End of MIPMAP CLASS***********************************/
@@ -0,0 +1,368 @@
+/**
+ * Conway's Game of Life simulation - engine
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#ifndef LIFE_ENGINE_H
+#define LIFE_ENGINE_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+const int TILE_ROWS = 32;					//	rows per activity tile
+const int TILE_WORDS = 8;					//	words per activity tile (512 cells)
+const int BLOCK_GENS = 32;					//	most generations run() steps per pass over memory
+const double BLOCK_IDLE = 0.5;				//	share of settled tiles above which run() steps one generation at a time
+
+/**
+ * @brief Grid Object
+ * @details Bit-packed cell storage, one bit per cell. Each row is a run of 64-bit
+ * 			words (cell x lives in bit x%64 of word x/64) padded out to a 64 byte
+ * 			boundary with at least one spare word. A blank halo row sits above and
+ * 			below the grid and a guard word sits in front of the first row, so the
+ * 			neighbours of every edge cell can be read without bounds checks. Padding
+ * 			and halo bits are always kept dead.
+ * 			Copies must be asked for by name, Grid b(a), so a whole-grid copy can't
+ * 			sneak into the generation loop; buffers trade places with swap().
+ * 			The image, from the front guard line to the back one, can also live
+ * 			in memory the grid doesn't own, so a snapshot can be stepped straight
+ * 			out of a mapped file.
+ */
+
+class Grid{
+	public:
+		Grid(int wide = 0, int tall = 0);
+		Grid(int wide, int tall, uint64_t * image, std::shared_ptr<void> owner);
+		explicit Grid(const Grid & other);
+		Grid(Grid && other) noexcept;
+		Grid & operator=(Grid && other) noexcept;
+		void swap(Grid & other) noexcept;
+		bool get(int x, int y) const;
+		void set(int x, int y, bool alive);
+		void setRun(int x, int y, int n);
+		void clear();
+		uint64_t * row(int y);
+		const uint64_t * row(int y) const;
+		uint64_t bits(int y, long long x) const;
+		int width() const { return wide; }
+		int height() const { return tall; }
+		size_t words() const { return nwords; }
+		size_t stride() const { return pitch; }
+		uint64_t tailMask() const;
+		void setEdge(int x, int y, bool alive);
+		const uint64_t * image() const { return base(); }
+		size_t imageWords() const { return 8 + (static_cast<size_t>(tall) + 2) * pitch + 8; }
+		static size_t pitchFor(int wide) { return ((static_cast<size_t>(wide) + 63) / 64 + 1 + 7) & ~static_cast<size_t>(7); }
+	private:
+		uint64_t * base();
+		const uint64_t * base() const;
+		std::vector<uint64_t> store;
+		std::shared_ptr<void> owner;	//	keeps a borrowed image alive, such as a mapped file
+		uint64_t * borrowed;
+		int wide;
+		int tall;
+		size_t nwords;
+		size_t pitch;
+};
+
+/**
+ * @brief Stats
+ * @details Counts for one step of a tile or a whole grid: live cells after it, the
+ * 			cells born and the ones that died in it, and the smallest box holding
+ * 			every live cell, inclusive, in cells. A box with x1 < x0 is empty.
+ */
+struct Stats{
+	Stats() : population(0), births(0), deaths(0), x0(0), y0(0), x1(-1), y1(-1) {}
+	void add(const Stats & other);
+	uint64_t population;
+	uint64_t births;
+	uint64_t deaths;
+	int x0, y0, x1, y1;
+};
+
+struct Rule;
+typedef bool (*StepFn)(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats);
+
+/**
+ * @brief Rule Object
+ * @details A Life-like birth/survive rule such as B3/S23. Bit k of birth is set when
+ * 			a dead cell with k live neighbours is born, bit k of survive when a live
+ * 			cell with k neighbours stays alive. A rule carries the step kernel built
+ * 			for it: the common rules get their own compile-time kernels, anything
+ * 			else runs a table-driven one. B0 rules would bring the dead border to
+ * 			life and aren't supported.
+ */
+
+struct Rule{
+	enum Kind{ GENERIC, CONWAY, HIGHLIFE, DAYNIGHT, SEEDS };
+	Rule();
+	bool parse(const std::string & text);
+	bool assign(unsigned birth, unsigned survive);
+	std::string str() const;
+	bool next(bool alive, int count) const { return (((alive ? survive : birth) >> count) & 1) != 0; }
+	unsigned birth;
+	unsigned survive;
+	Kind kind;
+	StepFn kernel;
+	int terms;				//	neighbour counts that appear in birth or survive,
+	int term[9];			//	the generic kernel only checks these
+};
+
+/**
+ * @brief stepRows
+ * @details Advance rows y0 to y1-1 of src by one generation into dst
+ */
+void stepRows(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1);
+bool stepRect(const Grid & src, Grid & dst, const Rule & rule, int y0, int y1, size_t w0, size_t w1, Stats * stats = 0);
+const char * kernelName();
+
+/**
+ * @brief Activity Object
+ * @details Tile-level record of which parts of a grid changed last generation. A
+ * 			tile only needs stepping if it or one of its eight neighbours changed;
+ * 			anything else is settled and comes out of the step as it went in. Flags
+ * 			are a byte per tile so bands on different threads never share a word,
+ * 			with a blank border of tiles so neighbour checks need no bounds checks.
+ * 			Changes are also gathered up until someone reading the grid, such as
+ * 			the density mipmap, has caught up with them. changed() is just the
+ * 			last generation and the edits made since.
+ * 			Once counting, every tile also keeps the Stats of its last step, filled
+ * 			in by the kernel as it goes; a skipped tile keeps its population and
+ * 			box, with nothing born or dying.
+ */
+
+class Activity{
+	public:
+		Activity(int wide = 0, int tall = 0);
+		void touch(int x, int y);
+		void touchAll();
+		bool active(int tx, int ty) const;
+		void mark(int tx, int ty, bool changed);
+		void flip();
+		void wrap();
+		bool changed(int tx, int ty) const { return last[at(tx, ty)] != 0; }
+		bool dirty(int tx, int ty) const { return seen[at(tx, ty)] != 0; }
+		void clean();
+		void count(bool on);
+		bool counting() const { return !counts.empty(); }
+		Stats * stats(int tx, int ty) { return counting() ? &counts[static_cast<size_t>(ty) * cols + tx] : 0; }
+		Stats total() const;
+		int across() const { return cols; }
+		int down() const { return rows; }
+	private:
+		size_t at(int tx, int ty) const { return static_cast<size_t>(ty + 1) * (cols + 2) + (tx + 1); }
+		std::vector<Stats> counts;			//	per tile, empty unless counting
+		std::vector<unsigned char> last;
+		std::vector<unsigned char> next;
+		std::vector<unsigned char> seen;	//	changed since the last clean()
+		int cols;
+		int rows;
+};
+size_t stepTiles(const Grid & src, Grid & dst, Activity & act, const Rule & rule, int ty0, int ty1);
+
+/**
+ * @brief Pool Object
+ * @details Persistent worker threads for stepping. Workers sleep between jobs, so
+ * 			there is no thread start-up per generation, and run() returns once every
+ * 			part of the job has finished, which acts as the generation barrier.
+ */
+
+class Pool{
+	public:
+		Pool(int threads = 0);
+		~Pool();
+		void run(int parts, const std::function<void(int)> & job);
+		int size() const { return static_cast<int>(workers.size()) + 1; }
+	private:
+		Pool(const Pool &);
+		Pool & operator=(const Pool &);
+		void work(int part);
+		std::vector<std::thread> workers;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		const std::function<void(int)> * job;
+		unsigned long long round;
+		int parts;
+		int pending;
+		bool stop;
+};
+
+/**
+ * @brief Edge policies
+ * @details What lies beyond the edge of a grid. Each policy fills the halo rows
+ * 			and the cells one step left and right of every row before a step, and
+ * 			the kernel reads them like any other neighbour, so the inner loop is the
+ * 			same for every topology. wraps says whether one edge's cells feed the
+ * 			far side, in which case edge tiles can't be skipped on their own.
+ * 			sides() does just the left and right, row by row, and beyond() says
+ * 			which row of the grid, if any, stands at a row past the top or bottom,
+ * 			for stepping bands of rows several generations at a time.
+ */
+
+struct DeadBorder{
+	static const bool wraps = false;
+	static void fill(Grid &){}
+	static void sides(Grid &){}
+	static int beyond(long long, int, bool &){ return -1; }
+};
+struct Torus{
+	static const bool wraps = true;
+	static void fill(Grid & grid);
+	static void sides(Grid & grid);
+	static int beyond(long long y, int tall, bool & flip);
+};
+struct KleinBottle{
+	static const bool wraps = true;
+	static void fill(Grid & grid);
+	static void sides(Grid & grid);
+	static int beyond(long long y, int tall, bool & flip);
+};
+struct Mirror{
+	static const bool wraps = false;
+	static void fill(Grid & grid);
+	static void sides(Grid & grid);
+	static int beyond(long long y, int tall, bool & flip);
+};
+
+/**
+ * @brief Step function
+ * @details One generation of a grid into its double buffer, for one topology.
+ * 			Returns the fraction of tiles skipped.
+ */
+typedef double (*Stepper)(Grid & src, Grid & dst, Activity & act, const Rule & rule, Pool & pool);
+Stepper pickStepper(int topology);
+
+/**
+ * @brief Block step function
+ * @details Several generations of a grid into its double buffer in one pass over
+ * 			memory, a band of rows at a time, for one topology. Returns the share
+ * 			of tiles the next single step would skip.
+ */
+typedef double (*Blocker)(Grid & src, Grid & dst, Activity & act, const Rule & rule, Pool & pool,
+		std::vector<Grid> & scratch, int gens, int band);
+Blocker pickBlocker(int topology);
+
+/**
+ * @brief Random Object
+ * @details Seeded generator (SplitMix64) for fills and blobs. Unlike std::rand it is
+ * 			the same on every platform and belongs to whoever holds it, so a seed
+ * 			always gives the same cells and a run can be replayed from its log.
+ * 			SplitMix is counter-based underneath: draw k of a seed is at(seed, k),
+ * 			so any part of a sequence can be had without the rest, on any thread.
+ */
+
+class Random{
+	public:
+		explicit Random(uint64_t seed = 0) : state(seed) {}
+		uint64_t next() { return mix(state += GOLDEN); }
+		bool coin() { return (next() >> 63) != 0; }
+		static uint64_t at(uint64_t seed, uint64_t counter) { return mix(seed + (counter + 1) * GOLDEN); }
+	private:
+		static const uint64_t GOLDEN = 0x9e3779b97f4a7c15ULL;
+		static uint64_t mix(uint64_t z){
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		}
+		uint64_t state;
+};
+
+/**
+ * @brief Engine Object
+ * @details A bounded universe on the bit-packed grid: the double buffer, tile
+ * 			activity, rule, topology and worker pool, stepped a generation at a
+ * 			time. Knows nothing about windows, so the game and the headless tools
+ * 			run exactly the same simulation.
+ * 			With count(true) the step kernel keeps Stats per tile as it runs, and
+ * 			stats() adds them up for the generation last stepped in time that
+ * 			grows with the number of tiles, not cells. Edits since that step
+ * 			aren't in them; population() counts the grid as it is.
+ * 			run() on a grid too big for the last level cache steps blockDepth()
+ * 			generations per pass over memory instead of one, with the same result.
+ */
+
+class Engine{
+	public:
+		Engine(int wide, int tall, const Rule & rule = Rule(), int topology = 0, int threads = 0);
+		Engine(Grid && cells, const Rule & rule, int topology, int threads, unsigned long long generation, unsigned seed);
+		void step();
+		void run(unsigned long long gens);
+		void advance(unsigned long long gens);
+		void fill(unsigned seed, double density = 0.5, long long origin = 0);
+		void clear();
+		bool get(int x, int y) const { return vect.get(x, y); }
+		void set(int x, int y, bool alive);
+		void setRun(long long x, long long y, long long n);
+		void setRow(int y, const uint64_t * words);
+		const Grid & cells() const { return vect; }
+		const Activity & tiles() const { return act; }
+		void clean() { act.clean(); }
+		const Rule & rule() const { return rules; }
+		Pool & workers() { return pool; }
+		int width() const { return vect.width(); }
+		int height() const { return vect.height(); }
+		int topology() const { return edges; }
+		unsigned seed() const { return seeded; }
+		unsigned long long generation() const { return gens; }
+		double idle() const { return skipped; }
+		uint64_t population() const;
+		void count(bool on) { act.count(on); }
+		bool counting() const { return act.counting(); }
+		Stats stats() const { return act.total(); }
+		void block(int gens) { blocking = gens; }
+		int blockDepth() const;
+	private:
+		Engine(const Engine &);
+		Engine & operator=(const Engine &);
+		Grid vect;
+		Grid tmp;
+		Activity act;
+		Rule rules;
+		Stepper stepper;
+		Blocker blocker;
+		Pool pool;
+		int edges;
+		unsigned seeded;
+		unsigned long long gens;
+		double skipped;
+		int blocking;						//	generations per pass in run(), 0 = from the cache sizes, 1 = off
+		std::vector<Grid> scratch;			//	band buffers for run(), two per worker
+};
+
+/**
+ * @brief Mipmap Object
+ * @details Population density of an engine's grid at every power-of-two scale, for
+ * 			drawing a grid far bigger than the screen. Level k holds a byte per
+ * 			2^k x 2^k block of cells, 0 when empty up to 255 when full, rounded up so
+ * 			a single live cell still shows at the coarsest level. update() only
+ * 			redoes the blocks over tiles that changed since it last ran.
+ */
+
+class Mipmap{
+	public:
+		Mipmap();
+		void update(Engine & engine);
+		int levels() const { return static_cast<int>(maps.size()); }
+		int width(int k) const { return (wide + (1 << k) - 1) >> k; }
+		int height(int k) const { return (tall + (1 << k) - 1) >> k; }
+		unsigned char at(int k, int bx, int by) const { return maps[k-1][static_cast<size_t>(by) * width(k) + bx]; }
+	private:
+		void redo(const Grid & grid, int x0, int y0, int x1, int y1);
+		std::vector< std::vector<unsigned char> > maps;	//	maps[k-1] is level k
+		int wide;
+		int tall;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * Conway's Game of Life simulation - ensembles
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "ensemble.h"
+#include "cycles.h"
+#include <cstdio>
+
+/**************************************TASKS CLASS***************************************/
+
+static thread_local const void * owner = 0;		//	pool the current thread works for
+static thread_local int mine = -1;				//	and its queue there
+
+/**
+ * @brief Tasks
+ * @details Start the workers, each with an empty queue
+ * @param threads workers, 0 for one per core
+ */
+Tasks::Tasks(int threads) : count(0), queued(0), pending(0), next(0), stop(false){
+	if(threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	if(threads <= 0)
+		threads = 1;
+	count = threads;	//	before any worker starts, as they read it
+	queues.reset(new Queue[threads]);
+	workers.reserve(threads);
+	for(int i = 0; i < threads; i++)
+		workers.push_back(std::thread(&Tasks::work, this, i));
+}
+Tasks::~Tasks(){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stop = true;
+	}
+	wake.notify_all();
+	for(size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+/**
+ * @brief push
+ * @details Queue a task. From one of the pool's own tasks it goes on that worker's
+ * 			queue, to be run next; from outside, the queues take turns.
+ */
+void Tasks::push(const std::function<void()> & task){
+	int q;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		pending++;	//	counted before it can run, so wait() can't see 0 early
+		q = owner == this ? mine : static_cast<int>(next++ % count);
+	}
+	{
+		std::lock_guard<std::mutex> guard(queues[q].lock);
+		queues[q].tasks.push_back(task);
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		queued++;
+	}
+	wake.notify_one();
+}
+/**
+ * @brief wait
+ * @details Block until every task pushed, and every task they pushed, has run
+ */
+void Tasks::wait(){
+	std::unique_lock<std::mutex> guard(lock);
+	while(pending > 0)
+		done.wait(guard);
+}
+/**
+ * @brief take
+ * @details The newest task on a worker's own queue, or failing that the oldest on
+ * 			anyone else's
+ * @return false if every queue was empty
+ */
+bool Tasks::take(int me, std::function<void()> & task){
+	int n = size();
+	for(int k = 0; k < n; k++){
+		Queue & q = queues[(me + k) % n];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if(q.tasks.empty())
+			continue;
+		if(k == 0){
+			task.swap(q.tasks.back());
+			q.tasks.pop_back();
+		}
+		else{
+			task.swap(q.tasks.front());
+			q.tasks.pop_front();
+		}
+		queued--;
+		return true;
+	}
+	return false;
+}
+/**
+ * @brief work
+ * @details Worker loop. Runs tasks while there are any to be had, then sleeps
+ * 			until more are queued.
+ * @param me this worker's queue
+ */
+void Tasks::work(int me){
+	owner = this;
+	mine = me;
+	for(;;){
+		std::function<void()> task;
+		if(take(me, task)){
+			task();
+			std::lock_guard<std::mutex> guard(lock);
+			if(--pending == 0)
+				done.notify_all();
+			continue;
+		}
+		std::unique_lock<std::mutex> guard(lock);
+		while(!stop && queued.load() == 0)
+			wake.wait(guard);
+		if(stop)
+			return;
+	}
+}
+/**********************************End of TASKS CLASS***********************************/
+
+
+/****************************************ENSEMBLE****************************************/
+
+/**
+ * @brief runEnsemble
+ * @details Run many random soups side by side, each on an engine of its own with
+ * 			a single thread, until it repeats or reaches the last generation. A
+ * 			soup is stepped a batch of generations per task and then queues its
+ * 			next batch, so it stays on one core unless another runs dry and steals
+ * 			it. Engines are made on their first batch and freed after their last,
+ * 			so only about one soup per thread is in memory at a time.
+ * @param wide number of cells across each soup
+ * @param tall number of cells down each soup
+ * @param rule birth/survive rule
+ * @param topology edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+ * @param density chance of each cell being alive to start with
+ * @param seed seed of the first soup, the rest count up from it
+ * @param count number of soups
+ * @param gens most generations to run a soup for
+ * @param threads workers, 0 for one per core
+ * @param batch generations per task
+ * @return each soup's result, in seed order
+ */
+std::vector<Soup> runEnsemble(int wide, int tall, const Rule & rule, int topology, double density,
+		unsigned seed, size_t count, unsigned long long gens, int threads, unsigned batch){
+	struct Universe{
+		std::unique_ptr<Engine> engine;
+		std::unique_ptr<Cycles> watch;
+	};
+	std::vector<Soup> soups(count);
+	std::vector<Universe> live(count);
+	Tasks pool(threads);
+	batch = std::max(1u, batch);
+	std::function<void(size_t)> advance = [&](size_t i){
+		Universe & u = live[i];
+		Soup & s = soups[i];
+		if(!u.engine){
+			s.seed = seed + static_cast<unsigned>(i);
+			u.engine.reset(new Engine(wide, tall, rule, topology, 1));
+			u.engine->fill(s.seed, density);
+			u.watch.reset(new Cycles(1024));
+			u.watch->update(*u.engine);
+		}
+		Engine & e = *u.engine;
+		for(unsigned b = 0; b < batch && e.generation() < gens && !u.watch->period(); b++){
+			e.step();
+			u.watch->update(e);
+		}
+		if(e.generation() < gens && !u.watch->period()){
+			pool.push([&advance, i]{ advance(i); });
+			return;
+		}
+		s.generations = e.generation();
+		s.population = e.population();
+		s.period = u.watch->period();
+		s.stable = s.period ? u.watch->since() : 0;
+		u.engine.reset();
+		u.watch.reset();
+	};
+	for(size_t i = 0; i < count; i++)
+		pool.push([&advance, i]{ advance(i); });
+	pool.wait();
+	return soups;
+}
+/**
+ * @brief writeEnsemble
+ * @details Write the results as CSV, a soup to a line
+ * @return false if the file couldn't be written
+ */
+bool writeEnsemble(const std::string & path, const std::vector<Soup> & soups){
+	std::FILE * out = std::fopen(path.c_str(), "w");
+	if(!out)
+		return false;
+	bool ok = std::fprintf(out, "seed,generations,population,stable,period\n") > 0;
+	for(size_t i = 0; ok && i < soups.size(); i++){
+		const Soup & s = soups[i];
+		ok = std::fprintf(out, "%u,%llu,%llu,%llu,%llu\n", s.seed, s.generations, s.population, s.stable, s.period) > 0;
+	}
+	ok = (std::fclose(out) == 0) && ok;
+	return ok;
+}
+/************************************End of ENSEMBLE*************************************/
@@ -0,0 +1,79 @@
+/**
+ * Conway's Game of Life simulation - ensembles
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_ENSEMBLE_H
+#define LIFE_ENSEMBLE_H
+
+#include "engine.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Tasks Object
+ * @details Work-stealing thread pool for many small independent jobs. Each worker
+ * 			has a queue of its own: it takes its newest task first, so a task that
+ * 			queues its own continuation stays on the same core with its data still
+ * 			in cache, and a worker with nothing left steals the oldest task from
+ * 			another. Unlike Pool there is no barrier between jobs.
+ */
+
+class Tasks{
+	public:
+		Tasks(int threads = 0);
+		~Tasks();
+		void push(const std::function<void()> & task);
+		void wait();
+		int size() const { return count; }
+	private:
+		Tasks(const Tasks &);
+		Tasks & operator=(const Tasks &);
+		struct Queue{
+			std::mutex lock;
+			std::deque< std::function<void()> > tasks;
+		};
+		bool take(int me, std::function<void()> & task);
+		void work(int me);
+		int count;							//	workers, fixed before the first one starts
+		std::vector<std::thread> workers;
+		std::unique_ptr<Queue[]> queues;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::atomic<long> queued;			//	tasks waiting in the queues
+		long pending;						//	tasks pushed and not yet finished, under lock
+		unsigned next;						//	queue for the next push from outside the pool
+		bool stop;
+};
+
+/**
+ * @brief Soup
+ * @details How one random soup of an ensemble turned out. A soup stops at the
+ * 			generation it is seen to repeat; stable and period are 0 if it ran to
+ * 			the end without repeating.
+ */
+struct Soup{
+	unsigned seed;
+	unsigned long long generations;			//	generations stepped
+	unsigned long long population;			//	live cells at the end
+	unsigned long long stable;				//	first generation of the cycle it settled into
+	unsigned long long period;
+};
+
+std::vector<Soup> runEnsemble(int wide, int tall, const Rule & rule, int topology, double density,
+		unsigned seed, size_t count, unsigned long long gens, int threads = 0, unsigned batch = 64);
+bool writeEnsemble(const std::string & path, const std::vector<Soup> & soups);
+
+#endif
@@ -0,0 +1,405 @@
+/**
+ * Conway's Game of Life simulation - HashLife engine
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#include "hashlife.h"
+#include <algorithm>
+
+/*************************************HASHLIFE CLASS*************************************/
+
+const uint32_t HashLife::NONE;
+
+/**
+ * @brief HashLife
+ * @details Empty universe. Nodes 0 and 1 are the dead and live leaf cells.
+ * @param rule birth/survive rule
+ * @param limit node count past which nodes are garbage collected, between steps
+ * 			or in the middle of one
+ */
+HashLife::HashLife(const Rule & rule, size_t limit) : limit(limit), ceiling(limit), rule(rule){
+	clear();
+}
+/**
+ * @brief clear
+ * @details Drop every node and start again from an empty universe at generation 0
+ */
+void HashLife::clear(){
+	nodes.clear();
+	blank.clear();
+	Node leaf = { 0, 0, 0, 0, NONE, NONE, 0, 0 };
+	nodes.push_back(leaf);
+	leaf.pop = 1;
+	nodes.push_back(leaf);
+	held.clear();
+	freed = NONE;
+	live = 2;
+	speed = -1;
+	gens = 0;
+	rehash(1 << 16);
+	root = empty(3);
+}
+/**
+ * @brief rehash
+ * @details Rebuild the hash table with the given number of buckets (a power of 2)
+ * 			from every node in use
+ */
+void HashLife::rehash(size_t buckets){
+	table.assign(buckets, NONE);
+	for(uint32_t i = 2; i < nodes.size(); i++){
+		if(nodes[i].level < 0)
+			continue;
+		const Node & n = nodes[i];
+		size_t h = (n.nw * 0x9e3779b1u + n.ne * 0x85ebca77u + n.sw * 0xc2b2ae3du + n.se * 0x27d4eb2fu) & (buckets - 1);
+		nodes[i].chain = table[h];
+		table[h] = i;
+	}
+}
+/**
+ * @brief join
+ * @details The one node made of these four quadrants, created if it's new
+ */
+uint32_t HashLife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+	size_t h = (nw * 0x9e3779b1u + ne * 0x85ebca77u + sw * 0xc2b2ae3du + se * 0x27d4eb2fu) & (table.size() - 1);
+	for(uint32_t i = table[h]; i != NONE; i = nodes[i].chain){
+		const Node & n = nodes[i];
+		if(n.nw == nw && n.ne == ne && n.sw == sw && n.se == se)
+			return i;
+	}
+	Node n = { nw, ne, sw, se, NONE, table[h],
+		nodes[nw].pop + nodes[ne].pop + nodes[sw].pop + nodes[se].pop, nodes[nw].level + 1 };
+	uint32_t i;
+	if(freed != NONE){
+		i = freed;
+		freed = nodes[i].chain;
+		nodes[i] = n;
+	}
+	else{
+		i = static_cast<uint32_t>(nodes.size());
+		nodes.push_back(n);
+	}
+	table[h] = i;
+	if(++live > table.size())
+		rehash(table.size() * 2);
+	return i;
+}
+/**
+ * @brief empty
+ * @details The blank node of a level
+ */
+uint32_t HashLife::empty(int level){
+	while(static_cast<int>(blank.size()) <= level){
+		if(blank.empty())
+			blank.push_back(0);
+		else{
+			uint32_t b = blank.back();
+			blank.push_back(join(b, b, b, b));
+		}
+	}
+	return blank[level];
+}
+/**
+ * @brief centre
+ * @details The half-size node in the middle of n
+ */
+uint32_t HashLife::centre(uint32_t n){
+	const Node & c = nodes[n];
+	return join(nodes[c.nw].se, nodes[c.ne].sw, nodes[c.sw].ne, nodes[c.se].nw);
+}
+/**
+ * @brief across
+ * @details The node straddling the boundary between side-by-side nodes w and e
+ */
+uint32_t HashLife::across(uint32_t w, uint32_t e){
+	return join(nodes[w].ne, nodes[e].nw, nodes[w].se, nodes[e].sw);
+}
+/**
+ * @brief downward
+ * @details The node straddling the boundary between stacked nodes n and s
+ */
+uint32_t HashLife::downward(uint32_t n, uint32_t s){
+	return join(nodes[n].sw, nodes[n].se, nodes[s].nw, nodes[s].ne);
+}
+/**
+ * @brief base
+ * @details Future of a 4x4 node: its middle 2x2 one generation on, by counting
+ * 			neighbours the long way.
+ */
+uint32_t HashLife::base(uint32_t n){
+	int cell[4][4];
+	const Node & c = nodes[n];
+	uint32_t quad[4] = { c.nw, c.ne, c.sw, c.se };
+	for(int q = 0; q < 4; q++){
+		const Node & k = nodes[quad[q]];
+		int x = (q & 1) * 2, y = (q >> 1) * 2;
+		cell[y][x] = k.nw;
+		cell[y][x+1] = k.ne;
+		cell[y+1][x] = k.sw;
+		cell[y+1][x+1] = k.se;
+	}
+	uint32_t out[4];
+	for(int q = 0; q < 4; q++){
+		int x = 1 + (q & 1), y = 1 + (q >> 1);
+		int count = cell[y-1][x-1] + cell[y-1][x] + cell[y-1][x+1]
+				  + cell[y][x-1]                  + cell[y][x+1]
+				  + cell[y+1][x-1] + cell[y+1][x] + cell[y+1][x+1];
+		out[q] = rule.next(cell[y][x] != 0, count);
+	}
+	return join(out[0], out[1], out[2], out[3]);
+}
+/**
+ * @brief future
+ * @details The middle half of n, 2^min(speed, level-2) generations on. Nine
+ * 			overlapping quarter-size nodes are advanced and reassembled into four,
+ * 			which are then advanced again at full speed or just re-centred when
+ * 			speed asks for fewer generations than the node could give.
+ * 			Past the node limit garbage is collected before any work is done. Every
+ * 			node still wanted by a caller further up is on the held stack by then,
+ * 			so the collection can't free it.
+ */
+uint32_t HashLife::future(uint32_t n){
+	if(nodes[n].next != NONE)
+		return nodes[n].next;
+	int level = nodes[n].level;
+	uint32_t result;
+	if(nodes[n].pop == 0)
+		result = empty(level - 1);
+	else if(level == 2)
+		result = base(n);
+	else{
+		size_t mark = held.size();
+		held.push_back(n);
+		if(live > ceiling)
+			collect();
+		uint32_t nw = nodes[n].nw, ne = nodes[n].ne, sw = nodes[n].sw, se = nodes[n].se;
+		uint32_t part[9];
+		part[0] = hold(future(nw));
+		part[1] = hold(future(across(nw, ne)));
+		part[2] = hold(future(ne));
+		part[3] = hold(future(downward(nw, sw)));
+		part[4] = hold(future(centre(n)));
+		part[5] = hold(future(downward(ne, se)));
+		part[6] = hold(future(sw));
+		part[7] = hold(future(across(sw, se)));
+		part[8] = hold(future(se));
+		uint32_t a = hold(join(part[0], part[1], part[3], part[4]));
+		uint32_t b = hold(join(part[1], part[2], part[4], part[5]));
+		uint32_t c = hold(join(part[3], part[4], part[6], part[7]));
+		uint32_t d = hold(join(part[4], part[5], part[7], part[8]));
+		if(speed >= level - 2){
+			uint32_t fa = hold(future(a));
+			uint32_t fb = hold(future(b));
+			uint32_t fc = hold(future(c));
+			uint32_t fd = future(d);
+			result = join(fa, fb, fc, fd);
+		}
+		else
+			result = join(centre(a), centre(b), centre(c), centre(d));
+		held.resize(mark);
+	}
+	nodes[n].next = result;
+	return result;
+}
+/**
+ * @brief expand
+ * @details Double the root around its centre with a blank border
+ */
+void HashLife::expand(){
+	const Node r = nodes[root];
+	uint32_t b = empty(r.level - 1);
+	root = join(join(b, b, b, r.nw), join(b, b, r.ne, b), join(b, r.sw, b, b), join(r.se, b, b, b));
+}
+/**
+ * @brief step
+ * @details Advance the universe 2^k generations. The root is grown until the
+ * 			pattern sits in its middle quarter with room to spare, which is far
+ * 			enough that nothing can reach the edge of the result in 2^k generations.
+ * 			Memoised futures are only good for one k, so changing k drops them.
+ * @param k log2 of the number of generations
+ */
+void HashLife::step(int k){
+	ceiling = limit;
+	if(live > ceiling)
+		collect();
+	if(k != speed){
+		for(size_t i = 0; i < nodes.size(); i++)
+			nodes[i].next = NONE;
+		speed = k;
+	}
+	while(nodes[root].level < k + 3 || nodes[centre(centre(root))].pop != nodes[root].pop)
+		expand();
+	root = future(root);
+	gens += 1ULL << k;
+}
+/**
+ * @brief collect
+ * @details Garbage collection. Marks everything reachable from the root, the
+ * 			blank nodes and the held stack and frees the rest. A memoised future
+ * 			is kept when its node and the future both survive. If what's left
+ * 			is still near the limit the next collection waits until there are
+ * 			twice as many nodes, so a step whose working set outgrows the limit
+ * 			doesn't spend its time collecting.
+ */
+void HashLife::collect(){
+	std::vector<unsigned char> mark(nodes.size(), 0);
+	std::vector<uint32_t> todo(blank.begin(), blank.end());
+	todo.insert(todo.end(), held.begin(), held.end());
+	todo.push_back(root);
+	mark[0] = mark[1] = 1;
+	while(!todo.empty()){
+		uint32_t n = todo.back();
+		todo.pop_back();
+		if(mark[n])
+			continue;
+		mark[n] = 1;
+		todo.push_back(nodes[n].nw);
+		todo.push_back(nodes[n].ne);
+		todo.push_back(nodes[n].sw);
+		todo.push_back(nodes[n].se);
+	}
+	freed = NONE;
+	live = 2;
+	for(uint32_t i = static_cast<uint32_t>(nodes.size()) - 1; i >= 2; i--){
+		if(mark[i]){
+			if(nodes[i].next != NONE && !mark[nodes[i].next])
+				nodes[i].next = NONE;
+			live++;
+			continue;
+		}
+		nodes[i].next = NONE;
+		nodes[i].level = -1;
+		nodes[i].chain = freed;
+		freed = i;
+	}
+	ceiling = std::max(limit, live * 2);
+	size_t buckets = 1 << 16;
+	while(buckets < live)
+		buckets *= 2;
+	rehash(buckets);
+}
+/**
+ * @brief build
+ * @details Node of the given level covering the square of the grid at (x,y),
+ * 			with anything outside the grid dead. Blank 64x64 blocks are found
+ * 			from the packed words without visiting their cells.
+ */
+uint32_t HashLife::build(const Grid & grid, long long x, long long y, int level){
+	long long side = 1LL << level;
+	if(x >= grid.width() || y >= grid.height() || x + side <= 0 || y + side <= 0)
+		return empty(level);
+	if(level == 0)
+		return grid.get(static_cast<int>(x), static_cast<int>(y));
+	if(level == 6 && x >= 0 && x % 64 == 0){
+		uint64_t any = 0;
+		for(long long r = std::max(y, 0LL); r < std::min(y + side, static_cast<long long>(grid.height())); r++)
+			any |= grid.row(static_cast<int>(r))[x / 64];
+		if(!any)
+			return empty(level);
+	}
+	long long h = side / 2;
+	return join(build(grid, x, y, level - 1), build(grid, x + h, y, level - 1),
+				build(grid, x, y + h, level - 1), build(grid, x + h, y + h, level - 1));
+}
+/**
+ * @brief load
+ * @details Replace the universe with the cells of a grid, grid cell (0,0) going
+ * 			to universe cell (0,0). The generation count is kept.
+ * @param grid cells to load
+ */
+void HashLife::load(const Grid & grid){
+	int level = 3;
+	while((1LL << (level - 1)) < std::max(grid.width(), grid.height()))
+		level++;
+	long long h = 1LL << (level - 1);
+	root = build(grid, -h, -h, level);
+}
+/**
+ * @brief spill
+ * @details Write the live cells of node n, whose corner is at (x,y), into a grid
+ */
+void HashLife::spill(uint32_t n, Grid & grid, long long x, long long y) const{
+	const Node & c = nodes[n];
+	long long side = 1LL << c.level;
+	if(c.pop == 0 || x >= grid.width() || y >= grid.height() || x + side <= 0 || y + side <= 0)
+		return;
+	if(c.level == 0){
+		grid.set(static_cast<int>(x), static_cast<int>(y), true);
+		return;
+	}
+	long long h = side / 2;
+	spill(c.nw, grid, x, y);
+	spill(c.ne, grid, x + h, y);
+	spill(c.sw, grid, x, y + h);
+	spill(c.se, grid, x + h, y + h);
+}
+/**
+ * @brief store
+ * @details Copy the universe into a grid, cell (0,0) to grid cell (0,0). Cells
+ * 			that fall outside the grid are dropped.
+ * @param grid destination, cleared first
+ */
+void HashLife::store(Grid & grid) const{
+	grid.clear();
+	long long h = 1LL << (nodes[root].level - 1);
+	spill(root, grid, -h, -h);
+}
+/**
+ * @brief get
+ * @details Read one cell of the universe
+ */
+bool HashLife::get(long long x, long long y) const{
+	uint32_t n = root;
+	long long h = 1LL << (nodes[root].level - 1);
+	if(x < -h || y < -h || x >= h || y >= h)
+		return false;
+	x += h;
+	y += h;
+	for(int level = nodes[root].level; level > 0; level--){
+		long long half = 1LL << (level - 1);
+		bool east = x >= half, south = y >= half;
+		const Node & c = nodes[n];
+		n = south ? (east ? c.se : c.sw) : (east ? c.ne : c.nw);
+		if(east)
+			x -= half;
+		if(south)
+			y -= half;
+	}
+	return n == 1;
+}
+/**
+ * @brief place
+ * @details Copy of node n with one cell changed, (x,y) relative to n's corner
+ */
+uint32_t HashLife::place(uint32_t n, long long x, long long y, bool alive){
+	const Node c = nodes[n];
+	if(c.level == 0)
+		return alive;
+	long long half = 1LL << (c.level - 1);
+	if(y < half){
+		if(x < half)
+			return join(place(c.nw, x, y, alive), c.ne, c.sw, c.se);
+		return join(c.nw, place(c.ne, x - half, y, alive), c.sw, c.se);
+	}
+	if(x < half)
+		return join(c.nw, c.ne, place(c.sw, x, y - half, alive), c.se);
+	return join(c.nw, c.ne, c.sw, place(c.se, x - half, y - half, alive));
+}
+/**
+ * @brief set
+ * @details Write one cell of the universe, growing the root to reach it
+ */
+void HashLife::set(long long x, long long y, bool alive){
+	for(;;){
+		long long h = 1LL << (nodes[root].level - 1);
+		if(x >= -h && y >= -h && x < h && y < h){
+			root = place(root, x + h, y + h, alive);
+			return;
+		}
+		expand();
+	}
+}
+/*********************************End of HASHLIFE CLASS**********************************/
@@ -0,0 +1,80 @@
+/**
+ * Conway's Game of Life simulation - HashLife engine
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#ifndef LIFE_HASHLIFE_H
+#define LIFE_HASHLIFE_H
+
+#include "engine.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief HashLife Object
+ * @details Memoised quadtree engine for jumping far ahead in one go. Every square of
+ * 			the universe is a node made of four half-size nodes, and identical
+ * 			squares share one node through a hash table, so a node's future only has
+ * 			to be worked out once. The universe is unbounded, centred on (0,0).
+ * 			Runs the same rules as the grid kernel so the two can be checked
+ * 			against each other while a pattern stays clear of the grid edge.
+ * 			Once the node count passes the limit unreachable nodes are collected,
+ * 			in the middle of a step too, so one long jump can't grow the store
+ * 			without bound.
+ */
+
+class HashLife{
+	public:
+		HashLife(const Rule & rule = Rule(), size_t limit = 1 << 22);
+		void load(const Grid & grid);
+		void store(Grid & grid) const;
+		bool get(long long x, long long y) const;
+		void set(long long x, long long y, bool alive);
+		void step(int k);
+		void clear();
+		void setLimit(size_t nodes) { limit = nodes; }
+		unsigned long long generation() const { return gens; }
+		uint64_t population() const { return nodes[root].pop; }
+		size_t size() const { return live; }
+	private:
+		struct Node{
+			uint32_t nw, ne, sw, se;	//	quadrants, or 0/1 for the two leaf cells
+			uint32_t next;				//	memoised future of the centre, NONE if unknown
+			uint32_t chain;				//	next node in the hash bucket or free list
+			uint64_t pop;				//	live cells under this node
+			int level;					//	node covers 2^level cells square
+		};
+		static const uint32_t NONE = 0xffffffffu;
+		uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+		uint32_t empty(int level);
+		uint32_t centre(uint32_t n);
+		uint32_t across(uint32_t w, uint32_t e);
+		uint32_t downward(uint32_t n, uint32_t s);
+		uint32_t base(uint32_t n);
+		uint32_t future(uint32_t n);
+		uint32_t hold(uint32_t n) { held.push_back(n); return n; }
+		uint32_t build(const Grid & grid, long long x, long long y, int level);
+		uint32_t place(uint32_t n, long long x, long long y, bool alive);
+		void expand();
+		void collect();
+		void rehash(size_t buckets);
+		void spill(uint32_t n, Grid & grid, long long x, long long y) const;
+		std::vector<Node> nodes;
+		std::vector<uint32_t> table;
+		std::vector<uint32_t> blank;
+		std::vector<uint32_t> held;		//	nodes a step in progress still needs
+		uint32_t root;
+		uint32_t freed;
+		size_t live;
+		size_t limit;
+		size_t ceiling;					//	node count that triggers the next collection
+		int speed;
+		unsigned long long gens;
+		Rule rule;
+};
+
+#endif
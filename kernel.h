@@ -0,0 +1,336 @@
+/**
+ * Conway's Game of Life simulation - inline step kernel
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#ifndef LIFE_KERNEL_H
+#define LIFE_KERNEL_H
+
+#include "engine.h"
+#include <cstring>
+
+/**
+ * The kernel is written once over a lane type V: a plain uint64_t for the scalar
+ * path, or a GCC vector of 4 or 8 words which compiles to AVX2 or AVX-512 when
+ * inlined into a function built for that target. Everything it calls must be
+ * force-inlined so it picks up the caller's instruction set.
+ */
+#if defined(__GNUC__)
+#define LIFE_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define LIFE_INLINE __forceinline
+#else
+#define LIFE_INLINE inline
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIFE_SIMD 1
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint64_t u64x8 __attribute__((vector_size(64)));
+#pragma GCC diagnostic ignored "-Wpsabi"	//	vector helpers are always inlined, never called
+#endif
+
+/**
+ * @brief popcount
+ * @details Number of live cells in a word
+ */
+static LIFE_INLINE int popcount(uint64_t w){
+#if defined(__GNUC__)
+	return __builtin_popcountll(w);
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+/**
+ * @brief lowest
+ * @details Position of the lowest live cell in a non-zero word
+ */
+static LIFE_INLINE int lowest(uint64_t w){
+#if defined(__GNUC__)
+	return __builtin_ctzll(w);
+#else
+	return popcount((w & (0 - w)) - 1);
+#endif
+}
+/**
+ * @brief highest
+ * @details Position of the highest live cell in a non-zero word
+ */
+static LIFE_INLINE int highest(uint64_t w){
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(w);
+#else
+	int hi = 63;
+	while(!(w >> hi & 1))
+		hi--;
+	return hi;
+#endif
+}
+/**
+ * @brief blank
+ * @details Whether words w0 to w1-1 of a row are all dead
+ */
+static LIFE_INLINE bool blank(const uint64_t * row, size_t w0, size_t w1){
+	uint64_t any = 0;
+	for(size_t i = w0; i < w1; i++)
+		any |= row[i];
+	return any == 0;
+}
+/**
+ * @brief load
+ * @details Unaligned load of sizeof(V)/8 words
+ */
+template<class V> static LIFE_INLINE V load(const uint64_t * p){
+	V v;
+	std::memcpy(&v, p, sizeof(V));
+	return v;
+}
+/**
+ * @brief tally
+ * @details Number of live cells over every lane
+ */
+template<class V> static LIFE_INLINE uint64_t tally(const V & v){
+	uint64_t lane[sizeof(V) / sizeof(uint64_t)];
+	std::memcpy(lane, &v, sizeof(V));
+	uint64_t n = 0;
+	for(size_t k = 0; k < sizeof(V) / sizeof(uint64_t); k++)
+		n += popcount(lane[k]);
+	return n;
+}
+/**
+ * @brief Planes Object
+ * @details Running count of live cells over a stream of words, kept bit-sliced
+ * 			the way neighbours() keeps its counts: bit j of plane k is bit k of the
+ * 			number of times bit j has been set, up to 15.
+ */
+template<class V> struct Planes{
+	Planes() : ones(), twos(), fours(), eights() {}
+	LIFE_INLINE void add(const V & v){
+		V c1 = ones & v;
+		ones ^= v;
+		V c2 = twos & c1;
+		twos ^= c1;
+		eights ^= fours & c2;
+		fours ^= c2;
+	}
+	LIFE_INLINE uint64_t drain(){
+		uint64_t n = tally(ones) + 2 * tally(twos) + 4 * tally(fours) + 8 * tally(eights);
+		ones = twos = fours = eights = V();
+		return n;
+	}
+	V ones, twos, fours, eights;
+};
+/**
+ * @brief Census Object
+ * @details Counts of the live, born and dying cells over a stream of words. Adding
+ * 			a word is a ripple of ANDs and XORs through the planes, which are only
+ * 			popcounted every 15 words, before they could overflow, so counting costs
+ * 			a few logic ops per word rather than three popcounts per lane.
+ */
+template<class V> struct Census{
+	Census() : held(0), live(0), born(0), died(0) {}
+	LIFE_INLINE void add(const V & next, const V & was){
+		nows.add(next);
+		births.add(next & ~was);
+		deaths.add(was & ~next);
+		if(++held == 15)
+			flush();
+	}
+	LIFE_INLINE void flush(){
+		live += nows.drain();
+		born += births.drain();
+		died += deaths.drain();
+		held = 0;
+	}
+	Planes<V> nows, births, deaths;
+	int held;
+	uint64_t live, born, died;
+};
+/**
+ * @brief WordCensus Object
+ * @details Census a popcount at a time, for single words on CPUs with a popcount
+ * 			instruction
+ */
+struct WordCensus{
+	WordCensus() : live(0), born(0), died(0) {}
+	LIFE_INLINE void add(uint64_t next, uint64_t was){
+		live += popcount(next);
+		born += popcount(next & ~was);
+		died += popcount(was & ~next);
+	}
+	LIFE_INLINE void flush(){}
+	uint64_t live, born, died;
+};
+/**
+ * @brief LaneCensus Object
+ * @details Census for CPUs that can popcount a whole vector at once (AVX-512
+ * 			VPOPCNTDQ): each lane keeps running totals of its own, added across
+ * 			only when flushed, so counting is a popcount and an add per count.
+ */
+template<class V> struct LaneCensus{
+	LaneCensus() : nows(), births(), deaths(), live(0), born(0), died(0) {}
+	LIFE_INLINE void add(const V & next, const V & was){
+		nows += counts(next);
+		births += counts(next & ~was);
+		deaths += counts(was & ~next);
+	}
+	LIFE_INLINE void flush(){
+		live += across(nows);
+		born += across(births);
+		died += across(deaths);
+		nows = births = deaths = V();
+	}
+	static LIFE_INLINE V counts(const V & v){
+		V c;
+		for(size_t k = 0; k < sizeof(V) / sizeof(uint64_t); k++)
+			c[k] = popcount(v[k]);
+		return c;
+	}
+	static LIFE_INLINE uint64_t across(const V & v){
+		uint64_t n = 0;
+		for(size_t k = 0; k < sizeof(V) / sizeof(uint64_t); k++)
+			n += v[k];
+		return n;
+	}
+	V nows, births, deaths;
+	uint64_t live, born, died;
+};
+/**
+ * @brief neighbours
+ * @details Live neighbour counts of 64 cells per lane at once. The eight neighbour
+ * 			bit-planes are summed with full adders into a 4-bit count per cell,
+ * 			b3 b2 b1 b0, which the rule then reads as plain boolean logic.
+ * @param up row above, starting at the word left of the ones being computed
+ * @param mid this row, same offset
+ * @param dn row below, same offset
+ */
+template<class V> static LIFE_INLINE void neighbours(const uint64_t * up, const uint64_t * mid, const uint64_t * dn,
+		V & alive, V & b0, V & b1, V & b2, V & b3){
+	alive = load<V>(mid + 1);
+	/**
+	 * Shift the neighbouring columns into line, carrying the edge bit across
+	 * from the word to either side
+	 */
+	V uc = load<V>(up + 1), dc = load<V>(dn + 1);
+	V uw = (uc << 1) | (load<V>(up) >> 63),  ue = (uc >> 1) | (load<V>(up + 2) << 63);
+	V mw = (alive << 1) | (load<V>(mid) >> 63), me = (alive >> 1) | (load<V>(mid + 2) << 63);
+	V dw = (dc << 1) | (load<V>(dn) >> 63),  de = (dc >> 1) | (load<V>(dn + 2) << 63);
+	/**
+	 * Row sums: full adders above and below, half adder on the middle row
+	 */
+	V us = uw ^ uc ^ ue, uk = (uw & uc) | (ue & (uw ^ uc));
+	V ds = dw ^ dc ^ de, dk = (dw & dc) | (de & (dw ^ dc));
+	V ms = mw ^ me, mk = mw & me;
+	/**
+	 * Ones column, then the four twos (three row carries plus the ones carry)
+	 */
+	b0 = us ^ ds ^ ms;
+	V c0 = (us & ds) | (ms & (us ^ ds));
+	V t0 = uk ^ dk ^ mk, t1 = (uk & dk) | (mk & (uk ^ dk));
+	b1 = t0 ^ c0;
+	V u1 = t0 & c0;
+	b2 = t1 ^ u1;
+	b3 = t1 & u1;
+}
+/**
+ * @brief countIs
+ * @details Cells whose neighbour count is k. 8 is the only count with b3 set.
+ */
+template<class V> static LIFE_INLINE V countIs(int k, const V & b0, const V & b1, const V & b2, const V & b3){
+	if(k == 8)
+		return b3;
+	return ~b3 & ((k & 4) ? b2 : ~b2) & ((k & 2) ? b1 : ~b1) & ((k & 1) ? b0 : ~b0);
+}
+/**
+ * @brief Match
+ * @details Compile-time walk over counts 0 to 8 collecting the cells born and kept
+ * 			by a fixed rule. Counts the rule doesn't use generate no code at all.
+ */
+template<unsigned B, unsigned S, int K> struct Match{
+	template<class V> static LIFE_INLINE void add(V & born, V & kept, const V & b0, const V & b1, const V & b2, const V & b3){
+		if(((B | S) >> K) & 1){
+			V eq = countIs<V>(K, b0, b1, b2, b3);
+			if((B >> K) & 1)
+				born |= eq;
+			if((S >> K) & 1)
+				kept |= eq;
+		}
+		Match<B, S, K + 1>::add(born, kept, b0, b1, b2, b3);
+	}
+};
+template<unsigned B, unsigned S> struct Match<B, S, 9>{
+	template<class V> static LIFE_INLINE void add(V &, V &, const V &, const V &, const V &, const V &){}
+};
+/**
+ * @brief FixedRule
+ * @details Rule known at compile time, B and S being the birth and survive masks
+ */
+template<unsigned B, unsigned S> struct FixedRule{
+	template<class V> static LIFE_INLINE V apply(const Rule &, const V & alive, const V & b0, const V & b1, const V & b2, const V & b3){
+		V born = V(), kept = V();
+		Match<B, S, 0>::add(born, kept, b0, b1, b2, b3);
+		return (born & ~alive) | (kept & alive);
+	}
+};
+/**
+ * @brief HighLife
+ * @details B36/S23 worked out by hand. 3 = 0011, 6 = 0110 and 2 = 0010, so every
+ * 			outcome needs b1 set and b3 clear; survival needs b2 clear, birth on 3
+ * 			needs b0, birth on 6 needs b2.
+ */
+template<> struct FixedRule<0x048, 0x00c>{
+	template<class V> static LIFE_INLINE V apply(const Rule &, const V & alive, const V & b0, const V & b1, const V & b2, const V & b3){
+		return ~b3 & b1 & ( (~b2 & (b0 | alive)) | (~alive & b2 & ~b0) );
+	}
+};
+/**
+ * @brief Conway
+ * @details B3/S23 worked out by hand: count 2 or 3 is b1 set with b2 and b3 clear,
+ * 			and a dead cell also needs b0 for 3.
+ */
+template<> struct FixedRule<0x008, 0x00c>{
+	template<class V> static LIFE_INLINE V apply(const Rule &, const V & alive, const V & b0, const V & b1, const V & b2, const V & b3){
+		return ~b3 & ~b2 & b1 & (b0 | alive);
+	}
+};
+typedef FixedRule<0x008, 0x00c> ConwayRule;		//	B3/S23
+typedef FixedRule<0x048, 0x00c> HighLifeRule;	//	B36/S23
+typedef FixedRule<0x1c8, 0x1d8> DayNightRule;	//	B3678/S34678
+typedef FixedRule<0x004, 0x000> SeedsRule;		//	B2/S
+/**
+ * @brief TableRule
+ * @details Any other rule, read from the Rule at run time. Only the counts listed in
+ * 			its term table are tested, so cost grows with the rule, not with 9.
+ */
+struct TableRule{
+	template<class V> static LIFE_INLINE V apply(const Rule & rule, const V & alive, const V & b0, const V & b1, const V & b2, const V & b3){
+		V born = V(), kept = V();
+		for(int i = 0; i < rule.terms; i++){
+			int k = rule.term[i];
+			V eq = countIs<V>(k, b0, b1, b2, b3);
+			if((rule.birth >> k) & 1)
+				born |= eq;
+			if((rule.survive >> k) & 1)
+				kept |= eq;
+		}
+		return (born & ~alive) | (kept & alive);
+	}
+};
+/**
+ * @brief lifeWord
+ * @details Next state of 64 cells per lane under rule R
+ */
+template<class V, class R> static LIFE_INLINE V lifeWord(const uint64_t * up, const uint64_t * mid, const uint64_t * dn, const Rule & rule){
+	V alive, b0, b1, b2, b3;
+	neighbours<V>(up, mid, dn, alive, b0, b1, b2, b3);
+	return R::template apply<V>(rule, alive, b0, b1, b2, b3);
+}
+
+#endif
@@ -11,7 +11,6 @@
  * 
  * ToDo:
  * 		Refine game window scale adjustments.
- * 		Add wrap around to cells when they reach the edge of the window.
  * 		Clean up UI and instructions.
  * 
  */
@@ -19,8 +18,22 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <SFML/Graphics/Font.hpp>
+#include "engine.h"
+#include "snapshot.h"
+#include "pattern.h"
+#include "record.h"
+#include "profile.h"
+#include "cycles.h"
 #include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <ctime>
 
 using namespace sf;
@@ -32,8 +45,86 @@ int fsize = 20;								//  Font size
 int menX = 8, menY = -3;					//	Button Text offset
 int size = 10;								//	default cell size
 int xwin = 640, ywin = 480;					//	default game window size
-int speed = 50000000;						//	default speed of animation
-#define WAIT for(int i=0; i<speed; i++);	//	Control animation speed
+int gridw = 0, gridh = 0;					//	universe size in cells, 0 = fit the window
+double rate = 20;							//	target generations per second
+int fps = 60;								//	target frames per second
+int threads = 0;							//	stepping threads, 0 = one per core
+double density = 0.5;						//	chance of each cell being alive in the fill
+int topology = 0;							//	edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+std::string rulestring = "B36/S23";			//	birth/survive rule, HighLife
+std::string snapfile = "life.snap";			//	snapshot F5 saves and F9 loads
+std::string patternfile = "life.rle";		//	pattern P pastes at the mouse, RLE, .cells or .mc
+std::string logfile = "life.log";			//	run log F6 starts and stops
+unsigned keyframes = 1000;					//	generations between keyframes in the run log
+std::string profilefile = "life.prof.json";	//	timings F7 writes
+
+/**
+ * @brief Scheduler Object
+ * @details Paces the game loop against the clock. Generations are owed at the
+ * 			target rate and paid off a frame at a time, so a fast rate runs many
+ * 			generations per frame and a slow one runs a generation every few
+ * 			frames. Stepping stops at the frame's budget so events are polled
+ * 			every frame however slow a generation is, and the loop sleeps out
+ * 			whatever is left of the frame instead of spinning.
+ */
+
+class Scheduler{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		Scheduler(double rate, int fps);
+		void setRate(double gens);
+		double getRate() const { return rate; }
+		long long due();
+		void ran(long long gens);
+		bool busy() const { return Clock::now() < budget; }
+		void hold();
+		void wait();
+	private:
+		Clock::duration frame;
+		Clock::time_point last;
+		Clock::time_point budget;
+		Clock::time_point next;
+		double rate;
+		double owed;
+};
+
+/**
+ * @brief Canvas Object
+ * @details The visible part of the grid as one texture, drawn with a single sprite,
+ * 			so the cost of a frame follows the size of the window rather than the
+ * 			universe. Close in, every cell owns a block of texels holding a copy of
+ * 			the cell glyph or nothing, and only rows of cells that differ from what
+ * 			was shown last are rebuilt and re-uploaded. Once a cell is smaller than
+ * 			a pixel, each texel is a block of the density mipmap instead.
+ */
+
+class Canvas{
+	public:
+		Canvas();
+		void create(const Image & glyph, int width, int height);
+		void update(const Grid & grid, const Mipmap & mip, double x, double y, float zoom);
+		const Sprite & sprite() const { return view; }
+	private:
+		void cells(const Grid & grid, double x, double y, double px, double py);
+		void blocks(const Mipmap & mip, double x, double y, double px, double py);
+		void scaleGlyph(int bw, int bh);
+		void fit(int w, int h);
+		void paint(const uint64_t * row, int r);
+		Texture board;
+		Sprite view;
+		std::vector<Uint8> glyph;	//	cell glyph as loaded, RGBA
+		std::vector<Uint32> stamp;	//	glyph at block size, cw x ch
+		std::vector<Uint32> pixels;	//	texels in use, cols*cw x rows*ch
+		std::vector<uint64_t> shown;	//	bit rows of the visible cells as last uploaded
+		Uint8 tint[4];				//	average colour of the glyph, for density
+		int gw, gh;					//	glyph size
+		int width, height;			//	area to cover, in pixels
+		int texw, texh;				//	texture size
+		int x0, y0, cols, rows;		//	cells or blocks shown
+		int cw, ch;					//	block size in texels
+		size_t words;
+		bool fresh;
+};
 
 /**
  * @brief Life Object
@@ -50,15 +141,32 @@ class Life{
 		void scale();
 		void fill();
 		void blob(int x, int y);
-		Texture skin;
-		Sprite cell;
+		bool cellAt(int mx, int my, int & x, int & y) const;
+		void zoomAt(float factor, int mx, int my);
+		void pan(double dx, double dy);
+		void home();
+		void restore();
+		void meter(double seconds, unsigned long long gens);
+		void edited();
+		Canvas board;
+		Mipmap mip;
 		Image icon;
 		RenderWindow window;
-		std::vector< std::vector<int> > vect;
-		std::vector< std::vector<int> > tmp;
+		std::unique_ptr<Engine> engine;
+		Recorder recorder;
+		Cycles cycles;
+		Random dice;				//	blob cells, seeded like the fill
+		Font hudFont;
+		Text hud;
+		bool showHud = false;
+		int drawn = 0;				//	frames rendered since the last meter()
+		Histogram lastStep;			//	timings as of the last meter()
+		Histogram lastRender;
 		int wide = 1;
 		int tall = 1;
 		float adjust;
+		double camX = 0, camY = 0;	//	cell at the top left of the view
+		float zoom = 1;				//	cell pitch is 30 x 24 pixels times zoom
 		bool yes;
 };
 
@@ -125,6 +233,297 @@ class Menu{
 		Image icon;
 };
 
+/*************************************SCHEDULER CLASS************************************/
+
+/**
+ * @brief Scheduler
+ * @details Start pacing from now with nothing owed
+ * @param rate target generations per second
+ * @param fps target frames per second
+ */
+Scheduler::Scheduler(double rate, int fps) : rate(rate), owed(0){
+	frame = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(fps, 1)));
+	last = Clock::now();
+	next = last + frame;
+	budget = last + frame * 3 / 4;
+}
+/**
+ * @brief setRate
+ * @details Change the target generations per second, kept between 1/4 and 1,000,000
+ */
+void Scheduler::setRate(double gens){
+	rate = std::min(std::max(gens, 0.25), 1e6);
+}
+/**
+ * @brief due
+ * @details Generations owed for this frame. The debt is capped at a few frames'
+ * 			worth, so a rate the machine can't keep up with (or a stall such as a
+ * 			window drag) runs as fast as it can rather than bursting to catch up.
+ */
+long long Scheduler::due(){
+	Clock::time_point now = Clock::now();
+	owed += std::chrono::duration<double>(now - last).count() * rate;
+	last = now;
+	owed = std::min(owed, rate * std::chrono::duration<double>(frame).count() * 4 + 1);
+	return static_cast<long long>(owed);
+}
+/**
+ * @brief ran
+ * @details Pay off generations that were run
+ */
+void Scheduler::ran(long long gens){
+	owed -= gens;
+}
+/**
+ * @brief hold
+ * @details Owe nothing for time spent paused
+ */
+void Scheduler::hold(){
+	last = Clock::now();
+	owed = 0;
+}
+/**
+ * @brief wait
+ * @details Sleep out the rest of the frame. A frame that overran starts the
+ * 			next one from now rather than trying to make up the time.
+ */
+void Scheduler::wait(){
+	Clock::time_point now = Clock::now();
+	if(next > now)
+		std::this_thread::sleep_until(next);
+	else
+		next = now;
+	budget = next + frame * 3 / 4;	//	the rest of the frame is left for rendering
+	next += frame;
+}
+/*********************************End of SCHEDULER CLASS*********************************/
+
+
+/***************************************CANVAS CLASS*************************************/
+
+Canvas::Canvas() : gw(0), gh(0), width(0), height(0), texw(0), texh(0), x0(0), y0(0), cols(0), rows(0),
+		cw(0), ch(0), words(0), fresh(true){
+	tint[0] = tint[1] = tint[2] = tint[3] = 0;
+}
+/**
+ * @brief create
+ * @details Take a copy of the glyph and the size of the area to cover
+ * @param glyph image drawn for a live cell
+ * @param width pixels across
+ * @param height pixels down
+ */
+void Canvas::create(const Image & glyph, int width, int height){
+	this->width = std::max(width, 1);
+	this->height = std::max(height, 1);
+	gw = glyph.getSize().x;
+	gh = glyph.getSize().y;
+	const Uint8 * src = glyph.getPixelsPtr();
+	if(!src)
+		gw = gh = 0;
+	this->glyph.assign(src, src + 4 * gw * gh);
+	src = this->glyph.data();
+	unsigned sum[4] = { 0, 0, 0, 0 };
+	for(int i = 0; i < gw * gh; i++){
+		for(int c = 0; c < 3; c++)
+			sum[c] += src[4 * i + c] * src[4 * i + 3];
+		sum[3] += src[4 * i + 3];
+	}
+	for(int c = 0; c < 3; c++)
+		tint[c] = static_cast<Uint8>(sum[3] ? sum[c] / sum[3] : 255);
+	tint[3] = 255;
+	cw = ch = 0;
+	fresh = true;
+}
+/**
+ * @brief update
+ * @details Bring the texture up to date with the grid as seen by the camera
+ * @param grid cells to show
+ * @param mip density of the same grid, used once a cell is below a pixel
+ * @param x cell at the left of the view
+ * @param y cell at the top of the view
+ * @param zoom cell pitch is 30 x 24 pixels times zoom
+ */
+void Canvas::update(const Grid & grid, const Mipmap & mip, double x, double y, float zoom){
+	double px = zoom * 30, py = zoom * 24;
+	if(std::min(px, py) >= 1 || mip.levels() == 0)
+		cells(grid, x, y, px, py);
+	else
+		blocks(mip, x, y, px, py);
+}
+/**
+ * @brief scaleGlyph
+ * @details Resample the glyph to a bw x bh block. Each texel averages the part of
+ * 			the 30x24 cell pitch it covers, so the glyph holds its shape close in
+ * 			and blurs rather than breaks up far out.
+ */
+void Canvas::scaleGlyph(int bw, int bh){
+	const int S = 4;	//	samples per texel each way
+	cw = bw;
+	ch = bh;
+	stamp.assign(static_cast<size_t>(cw) * ch, 0);
+	for(int j = 0; j < ch; j++){
+		for(int i = 0; i < cw; i++){
+			unsigned sum[4] = { 0, 0, 0, 0 };
+			for(int b = 0; b < S; b++){
+				for(int a = 0; a < S; a++){
+					int u = (i * S + a) * 30 / (cw * S);
+					int v = (j * S + b) * 24 / (ch * S);
+					if(u < gw && v < gh){
+						for(int c = 0; c < 4; c++)
+							sum[c] += glyph[4 * (v * gw + u) + c];
+					}
+				}
+			}
+			Uint8 texel[4];
+			for(int c = 0; c < 4; c++)
+				texel[c] = static_cast<Uint8>(sum[c] / (S * S));
+			std::memcpy(&stamp[j * cw + i], texel, 4);
+		}
+	}
+}
+/**
+ * @brief fit
+ * @details Make sure the texture holds w x h texels and show just that much of it
+ */
+void Canvas::fit(int w, int h){
+	if(w > texw || h > texh){
+		texw = std::max(w, texw);
+		texh = std::max(h, texh);
+		board.create(texw, texh);
+		view.setTexture(board, true);
+	}
+	view.setTextureRect(IntRect(0, 0, w, h));
+}
+/**
+ * @brief cells
+ * @details Draw a cell per block. Only the rows of cells whose bits differ from
+ * 			the last upload are repainted, and runs of them go up as one band each;
+ * 			past a handful of runs the span from the first to the last goes up in
+ * 			one, as a few big uploads beat many small ones.
+ */
+void Canvas::cells(const Grid & grid, double x, double y, double px, double py){
+	int bw = std::max(1, static_cast<int>(std::ceil(px)));
+	int bh = std::max(1, static_cast<int>(std::ceil(py)));
+	if(bw != cw || bh != ch){
+		scaleGlyph(bw, bh);
+		fresh = true;
+	}
+	int nx = static_cast<int>(std::floor(x)), ny = static_cast<int>(std::floor(y));
+	int nc = static_cast<int>(std::ceil(width / px)) + 1, nr = static_cast<int>(std::ceil(height / py)) + 1;
+	if(fresh || nx != x0 || ny != y0 || nc != cols || nr != rows){
+		x0 = nx;
+		y0 = ny;
+		cols = nc;
+		rows = nr;
+		words = (cols + 63) / 64;
+		shown.assign(words * rows, 0);
+		pixels.assign(static_cast<size_t>(cols) * cw * rows * ch, 0);
+		fresh = true;
+	}
+	fit(cols * cw, rows * ch);
+	view.setScale(px / cw, py / ch);
+	view.setPosition(10 + (x0 - x) * px, 10 + (y0 - y) * py);
+
+	const int RUNS = 8;
+	int first[RUNS], last[RUNS];
+	int runs = 0, top = -1, bottom = -1;
+	uint64_t keep = cols % 64 ? (1ULL << (cols % 64)) - 1 : ~0ULL;
+	std::vector<uint64_t> bits(words);
+	for(int r = 0; r < rows; r++){
+		int gy = y0 + r;
+		bool on = gy >= 0 && gy < grid.height();
+		for(size_t i = 0; i < words; i++)
+			bits[i] = on ? grid.bits(gy, x0 + 64LL * static_cast<long long>(i)) : 0;
+		bits[words-1] &= keep;
+		uint64_t * old = &shown[r * words];
+		if(!fresh && std::equal(bits.begin(), bits.end(), old))
+			continue;
+		std::copy(bits.begin(), bits.end(), old);
+		paint(old, r);
+		if(top < 0)
+			top = r;
+		if(runs > 0 && runs <= RUNS && last[runs-1] == r - 1)
+			last[runs-1] = r;
+		else{
+			if(runs < RUNS){
+				first[runs] = r;
+				last[runs] = r;
+			}
+			runs++;
+		}
+		bottom = r;
+	}
+	fresh = false;
+	if(top < 0)
+		return;
+	if(runs > RUNS){
+		runs = 1;
+		first[0] = top;
+		last[0] = bottom;
+	}
+	size_t span = static_cast<size_t>(cols) * cw;
+	for(int i = 0; i < runs; i++){
+		const Uint8 * band = reinterpret_cast<const Uint8 *>(&pixels[first[i] * ch * span]);
+		board.update(band, cols * cw, (last[i] - first[i] + 1) * ch, 0, first[i] * ch);
+	}
+}
+/**
+ * @brief paint
+ * @details Rebuild the texels of one row of visible cells
+ */
+void Canvas::paint(const uint64_t * row, int r){
+	size_t span = static_cast<size_t>(cols) * cw;
+	Uint32 * out = &pixels[static_cast<size_t>(r) * ch * span];
+	for(int j = 0; j < ch; j++, out += span){
+		const Uint32 * glyph = &stamp[j * cw];
+		for(int x = 0; x < cols; x++){
+			if(row[x >> 6] >> (x & 63) & 1)
+				std::memcpy(out + x * cw, glyph, cw * sizeof(Uint32));
+			else
+				std::memset(out + x * cw, 0, cw * sizeof(Uint32));
+		}
+	}
+}
+/**
+ * @brief blocks
+ * @details Draw a texel per block of the coarsest mipmap level whose blocks are
+ * 			still at least a pixel, shaded by how full each block is. Always a
+ * 			whole repaint, but of no more texels than the area has pixels.
+ */
+void Canvas::blocks(const Mipmap & mip, double x, double y, double px, double py){
+	int k = 1;
+	while(k < mip.levels() && std::min(px, py) * (1 << k) < 1)
+		k++;
+	double side = 1 << k;
+	double bx = x / side, by = y / side;
+	double bpx = px * side, bpy = py * side;
+	x0 = static_cast<int>(std::floor(bx));
+	y0 = static_cast<int>(std::floor(by));
+	cols = static_cast<int>(std::ceil(width / bpx)) + 1;
+	rows = static_cast<int>(std::ceil(height / bpy)) + 1;
+	pixels.assign(static_cast<size_t>(cols) * rows, 0);
+	int mw = mip.width(k), mh = mip.height(k);
+	for(int r = 0; r < rows; r++){
+		int gy = y0 + r;
+		if(gy < 0 || gy >= mh)
+			continue;
+		for(int c = std::max(0, -x0); c < cols && x0 + c < mw; c++){
+			unsigned char d = mip.at(k, x0 + c, gy);
+			if(d){
+				Uint8 texel[4] = { tint[0], tint[1], tint[2], d };
+				std::memcpy(&pixels[static_cast<size_t>(r) * cols + c], texel, 4);
+			}
+		}
+	}
+	fit(cols, rows);
+	view.setScale(bpx, bpy);
+	view.setPosition(10 + (x0 - bx) * bpx, 10 + (y0 - by) * bpy);
+	board.update(reinterpret_cast<const Uint8 *>(pixels.data()), cols, rows, 0, 0);
+	fresh = true;	//	the texture no longer holds cells
+}
+/***********************************End of CANVAS CLASS*********************************/
+
+
 /**
  * @brief Set Environment
  * @details Creates window for the actual game based on default settings
@@ -132,20 +531,24 @@ class Menu{
  */
 
 Life::Life(bool yes) : window(VideoMode(xwin, ywin), "Game of Life Simulation", Style::Close){
-	scale();	
+	scale();
+	Rule rule;
+	if(!rule.parse(rulestring))
+		rule = Rule();
+	engine.reset(new Engine(wide, tall, rule, topology, threads));
+	if(hudFont.loadFromFile("assets/fdat")){
+		hud.setFont(hudFont);
+		hud.setCharacterSize(fsize - 6);
+		hud.setColor(Color::Yellow);
+		hud.setPosition(14, 12);
+	}
 	if(!icon.loadFromFile("assets/cdat")){
 		return;
 	}
 	window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
-	if(!skin.loadFromFile("assets/cdat")){
-		return;
-	}
-	
-	cell.setTexture(skin);
-	cell.setScale(adjust, adjust);
-	std::vector< std::vector<int> > a(wide, std::vector<int>(tall,0));
-	vect = a;
-	tmp = a;
+	board.create(icon, xwin - 20, ywin - 20);
+	zoom = adjust;
+	dice = Random(std::time(NULL));
 	if(!yes)
 		fill();
 }
@@ -155,30 +558,83 @@ Life::Life(bool yes) : window(VideoMode(xwin, ywin), "Game of Life Simulation",
  */
 void Life::run(){
 	bool pause = false;
+	bool dirty = true;
+	int frames = 0;
+	Scheduler clock(rate, fps);
+	Clock metered;
+	unsigned long long lastGen = engine->generation();
 	while(window.isOpen()){
 		Event event;
 		while(window.pollEvent(event)){
+			LIFE_TIME(INPUT);
 			if(event.type == Event::Closed){
 				window.close();
 			}
+			if(event.type == Event::GainedFocus){
+				dirty = true;
+			}
 			if(event.type == Event::MouseWheelMoved){
-				speed += (event.mouseWheel.delta * -10000000);
-				if(speed <= 0)
-					speed = 1000;
-				else if(speed >= 999999999)
-					speed = 999999999;
+				if(Keyboard::isKeyPressed(Keyboard::LControl) || Keyboard::isKeyPressed(Keyboard::RControl))
+					zoomAt(event.mouseWheel.delta > 0 ? 1.25f : 0.8f, event.mouseWheel.x, event.mouseWheel.y);
+				else{	//	each notch doubles or halves the rate
+					clock.setRate(clock.getRate() * (event.mouseWheel.delta > 0 ? 2 : 0.5));
+					rate = clock.getRate();
+				}
+				dirty = true;
+			}
+			if(event.type == Event::KeyPressed){
+				double step = 0.125 * (xwin - 20) / (zoom * 30);	//	an eighth of the view
+				switch(event.key.code){
+					case Keyboard::Left:		pan(-step, 0); break;
+					case Keyboard::Right:		pan(step, 0); break;
+					case Keyboard::Up:			pan(0, -step); break;
+					case Keyboard::Down:		pan(0, step); break;
+					case Keyboard::Add:
+					case Keyboard::Equal:		zoomAt(1.25f, xwin / 2, ywin / 2); break;
+					case Keyboard::Subtract:
+					case Keyboard::Dash:		zoomAt(0.8f, xwin / 2, ywin / 2); break;
+					case Keyboard::Home:		home(); break;
+					case Keyboard::F5:			saveSnapshot(snapfile, *engine, true); break;
+					case Keyboard::F9:			restore(); break;
+					case Keyboard::F3:
+						showHud = !showHud;
+						engine->count(showHud);	//	the overlay's counts come out of the step
+						break;
+					case Keyboard::F7:			Profile::write(profilefile); break;
+					case Keyboard::F6:
+						if(recorder.recording())
+							recorder.close();
+						else
+							recorder.open(logfile, *engine, keyframes);
+						break;
+					case Keyboard::P:{
+						Vector2i m = Mouse::getPosition(window);
+						int x, y;
+						if(cellAt(m.x, m.y, x, y)){
+							placePattern(patternfile, *engine, x, y);
+							edited();
+						}
+						break;
+					}
+					default:					break;
+				}
+				dirty = true;
 			}
 			if(event.type == Event::MouseButtonPressed){
+				int x, y;
 				if(event.mouseButton.button == Mouse::Left){
-					int x = ( (event.mouseButton.x) - 10 ) / (adjust*30);
-					int y = ( (event.mouseButton.y) - 10 ) / (adjust*24);
-					blob(x,y);
+					if(cellAt(event.mouseButton.x, event.mouseButton.y, x, y)){
+						blob(x,y);
+						edited();
+					}
+					dirty = true;
 				}
 				if(event.mouseButton.button == Mouse::Middle){
-					int x = ( (event.mouseButton.x) - 10 ) / (adjust*30);
-					int y = ( (event.mouseButton.y) - 10 ) / (adjust*24);
-					if(x < wide && y < tall )
-						vect[x][y] = 0;
+					if(cellAt(event.mouseButton.x, event.mouseButton.y, x, y)){
+						engine->set(x, y, false);
+						edited();
+						dirty = true;
+					}
 				}
 				if(event.mouseButton.button == Mouse::Right){
 					if(!pause)
@@ -188,10 +644,36 @@ void Life::run(){
 				}
 			}
 		}
-		WAIT
-		if(!pause)
-			update();
-		render();
+		if(!pause){
+			long long gens = clock.due();
+			long long done = 0;
+			while(done < gens && clock.busy()){
+				update();
+				done++;
+			}
+			clock.ran(done);
+			dirty = dirty || done > 0;
+		}
+		else
+			clock.hold();
+		if(++frames % (fps / 2 + 1) == 0){	//	about twice a second
+			char title[128];
+			int len = std::snprintf(title, sizeof(title), "Game of Life Simulation - %g gen/s - %d%% settled",
+					clock.getRate(), static_cast<int>(engine->idle() * 100));
+			if(cycles.period())
+				std::snprintf(title + len, sizeof(title) - len, " - period %llu", cycles.period());
+			window.setTitle(title);
+			if(showHud){
+				meter(metered.restart().asSeconds(), engine->generation() - std::min(lastGen, engine->generation()));
+				lastGen = engine->generation();
+				dirty = true;
+			}
+		}
+		if(dirty && window.isOpen()){
+			render();
+			dirty = false;
+		}
+		clock.wait();
 	}
 }
 /**
@@ -201,96 +683,97 @@ void Life::run(){
  * @param y y-axis position
  */
 void Life::blob(int x, int y){
-	if(x > 0 && y > 0 && x < wide-1 && y < tall ){
-		vect[x][y] = 1;
-		vect[x-1][y] = std::rand() % 2;
-		vect[x+1][y] = std::rand() % 2;
-		vect[x][y-1] = std::rand() % 2;
-		vect[x][y+1] = std::rand() % 2;
-		vect[x-1][y-1] = std::rand() % 2;
-		vect[x+1][y+1] = std::rand() % 2;
-		vect[x-1][y+1] = std::rand() % 2;
-		vect[x+1][y-1] = std::rand() % 2;
+	if(x > 0 && y > 0 && x < wide-1 && y < tall-1 ){
+		engine->set(x, y, true);
+		engine->set(x-1, y, dice.coin());
+		engine->set(x+1, y, dice.coin());
+		engine->set(x, y-1, dice.coin());
+		engine->set(x, y+1, dice.coin());
+		engine->set(x-1, y-1, dice.coin());
+		engine->set(x+1, y+1, dice.coin());
+		engine->set(x-1, y+1, dice.coin());
+		engine->set(x+1, y-1, dice.coin());
 	}
 }
 /**
  * @brief Fill
- * @details Fill environment with random occurrences of cells
+ * @details Fill environment with random occurrences of cells. Blobs then draw
+ * 			from the same seed, so one number repeats a session's random cells.
  */
 void Life::fill(){
-	std::srand(std::time(NULL));
-	for(int y = 0; y < wide; y++){
-		for(int z = 0; z < tall; z++){
-			int num = std::rand() % 2;
-			if(num == 1){
-				vect[y][z] = 1;
-			}
-			else{
-				vect[y][z] = 0;
-			}
-		}
-	}
+	unsigned seed = static_cast<unsigned>(std::time(NULL));
+	engine->fill(seed, density);
+	dice = Random(seed);
 }
 /**
  * @brief update
- * @details update environment based on set of rules. Only one or the other should be used.
+ * @details update environment based on set of rules, read from rulestring.
  * 			B - Birth, S - Survive
  * 			Conway:		B3/S23
- * 			HighLife:	B36/S23	<-- Used in this simulation for better patterns, described below
- * 			Build tmp environment based on current environment
+ * 			HighLife:	B36/S23	<-- Default for this simulation for better patterns
+ * 			Build tmp environment based on current environment, 64 cells per word,
+ * 			with the edges handled as the topology default says (see stepGrid()).
+ * 			Tiles that have settled are skipped, and Engine::idle() keeps the
+ * 			fraction skipped.
  */
 void Life::update(){
-	for(int y = 0; y < wide; y++){
-		for(int z = 0; z < tall; z++){
-			/**
-			 * Awareness of surrounding cells
-			 */
-			int count = 0;
-			if(y > 0 && vect[y-1][z] == 1)
-				count++;
-			if(y > 0 && z < tall && vect[y-1][z+1] == 1)
-				count++;
-			if(z < tall && vect[y][z+1] == 1)
-				count++;
-			if(y < wide-1 && z < tall && vect[y+1][z+1] == 1)
-				count++;
-			if(y < wide-1 && vect[y+1][z] == 1)
-				count++;
-			if(y < wide-1 && z > 0 && vect[y+1][z-1] == 1)
-				count++;
-			if(z > 0 && vect[y][z-1] == 1)
-				count++;
-			if(y > 0 && z > 0 && vect[y-1][z-1] == 1)
-				count++;
-			/**
-			 * @brief Highlife Rules
-			 * @details B36/S23	-- Birth when 3 or 6 adjacent, survive when 2-3 adjacent, else death
-			 */
-			if(vect[y][z] == 1 && (count < 2 || count > 3) )			//	Death condition
-				tmp[y][z] = 0;
-			else if(vect[y][z] == 1 && (count >= 2 || count <= 3))		//	Survival condition
-				tmp[y][z] = 1;
-			else if(vect[y][z] == 0 && (count == 3 || count == 6))		//	Birth condition
-				tmp[y][z] = 1;
-		}
-	}
-	vect = tmp;	//	Make current environment equal to new environment
+	engine->step();
+	recorder.step(*engine);
+	cycles.update(*engine);
+}
+/**
+ * @brief edited
+ * @details Tell the run log and the cycle watch about cells changed by hand
+ */
+void Life::edited(){
+	recorder.edit(*engine);
+	cycles.update(*engine);
 }
 /**
  * @brief Render
  * @details Display current environment
  */
 void Life::render(){
+	LIFE_TIME(RENDER);
 	window.clear();
-	for(int x = 0; x < wide; x++){
-		for(int y = 0; y < tall; y++){
-			if(vect[x][y] == 1){
-				cell.setPosition( (x*(adjust*30)+10) , (y*(adjust*24)+10) ) ;
-			}
-			window.draw(cell);
-		}
-	}
+	if(zoom * 24 < 1)
+		mip.update(*engine);
+	board.update(engine->cells(), mip, camX, camY, zoom);
+	window.draw(board.sprite());
+	if(showHud)
+		window.draw(hud);
 	window.display();
+	drawn++;
+}
+/**
+ * @brief meter
+ * @details Refresh the overlay with the rates since the last refresh, the counts
+ * 			the kernel kept for the last generation and the step and render times
+ * 			recorded in between
+ * @param seconds time since the last refresh
+ * @param gens generations stepped since the last refresh
+ */
+void Life::meter(double seconds, unsigned long long gens){
+	Histogram step = Profile::read(Profile::STEP), paint = Profile::read(Profile::RENDER);
+	Histogram stepped = step, painted = paint;
+	stepped.subtract(lastStep);
+	painted.subtract(lastRender);
+	lastStep = step;
+	lastRender = paint;
+	Stats now = engine->stats();
+	char text[320];
+	int len = std::snprintf(text, sizeof(text), "%.0f gen/s  %.0f fps\npopulation %llu  +%llu -%llu\nbox %d,%d to %d,%d\n",
+			seconds > 0 ? gens / seconds : 0, seconds > 0 ? drawn / seconds : 0,
+			static_cast<unsigned long long>(now.population), static_cast<unsigned long long>(now.births),
+			static_cast<unsigned long long>(now.deaths), now.x0, now.y0, now.x1, now.y1);
+	if(LIFE_PROFILE)
+		std::snprintf(text + len, sizeof(text) - len, "step p50 %.0f us  p99 %.0f us\nrender p50 %.0f us  p99 %.0f us",
+				stepped.percentile(0.5) / 1e3, stepped.percentile(0.99) / 1e3,
+				painted.percentile(0.5) / 1e3, painted.percentile(0.99) / 1e3);
+	else
+		std::snprintf(text + len, sizeof(text) - len, "(built without timers)");
+	hud.setString(text);
+	drawn = 0;
 }
 /**
  * @brief Scale
@@ -349,6 +832,79 @@ void Life::scale(){
 			adjust = 1;
 			break;
 	}
+	if(gridw > 0 && gridh > 0){	//	a universe of its own size, seen through the camera
+		wide = gridw;
+		tall = gridh;
+	}
+}
+/**
+ * @brief cellAt
+ * @details Cell under a window position
+ * @param mx x-axis pixel
+ * @param my y-axis pixel
+ * @param x x-axis cell, set even if off the grid
+ * @param y y-axis cell, set even if off the grid
+ * @return true if the cell is on the grid
+ */
+bool Life::cellAt(int mx, int my, int & x, int & y) const{
+	x = static_cast<int>(std::floor(camX + (mx - 10) / (zoom * 30)));
+	y = static_cast<int>(std::floor(camY + (my - 10) / (zoom * 24)));
+	return x >= 0 && y >= 0 && x < wide && y < tall;
+}
+/**
+ * @brief zoomAt
+ * @details Zoom in or out keeping the cell under a window position where it is.
+ * 			Zoom runs from a cell of 120 pixels out to the whole grid in a few
+ * 			pixels.
+ * @param factor scale to apply
+ * @param mx x-axis pixel to hold still
+ * @param my y-axis pixel to hold still
+ */
+void Life::zoomAt(float factor, int mx, int my){
+	double x = camX + (mx - 10) / (zoom * 30);
+	double y = camY + (my - 10) / (zoom * 24);
+	float least = std::min(8.0f / (std::max(wide, tall) * 24), 0.1f);
+	zoom = std::min(std::max(zoom * factor, least), 4.0f);
+	camX = x - (mx - 10) / (zoom * 30);
+	camY = y - (my - 10) / (zoom * 24);
+	pan(0, 0);
+}
+/**
+ * @brief pan
+ * @details Move the camera by a number of cells, keeping some of the grid in view
+ */
+void Life::pan(double dx, double dy){
+	double across = (xwin - 20) / (zoom * 30);
+	double down = (ywin - 20) / (zoom * 24);
+	camX = std::min(std::max(camX + dx, -across / 2), wide - across / 2);
+	camY = std::min(std::max(camY + dy, -down / 2), tall - down / 2);
+}
+/**
+ * @brief home
+ * @details Back to the menu's cell size, looking at the top left corner
+ */
+void Life::home(){
+	zoom = adjust;
+	camX = camY = 0;
+}
+/**
+ * @brief restore
+ * @details Carry on from the snapshot file. The grid takes the snapshot's size,
+ * 			rule and topology; a missing or damaged file leaves the game as it is.
+ * 			A run log being recorded ends where the snapshot takes over, and the
+ * 			cycle watch starts again from the new cells.
+ */
+void Life::restore(){
+	std::unique_ptr<Engine> saved = loadSnapshot(snapfile, threads);
+	if(!saved)
+		return;
+	recorder.close();
+	engine.swap(saved);
+	engine->count(showHud);
+	cycles.update(*engine);
+	wide = engine->width();
+	tall = engine->height();
+	pan(0, 0);
 }
 /***********************************End of LIFE CLASS************************************/
 
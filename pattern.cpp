@@ -0,0 +1,663 @@
+/**
+ * Conway's Game of Life simulation - pattern files
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "pattern.h"
+#include "kernel.h"
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+static const long long MOST = 1LL << 62;	//	largest count or size a file may give
+
+/**
+ * @brief Input Object
+ * @details A file read a megabyte at a time, one character after another
+ */
+
+class Input{
+	public:
+		Input(std::FILE * in) : in(in), buf(1 << 20), at(0), end(0) {}
+		int get() { return at < end || refill() ? buf[at++] : EOF; }
+		int peek() { return at < end || refill() ? buf[at] : EOF; }
+		bool line(std::string & text);
+		void skipLine();
+	private:
+		bool refill();
+		std::FILE * in;
+		std::vector<unsigned char> buf;
+		size_t at, end;
+};
+bool Input::refill(){
+	at = 0;
+	end = std::fread(buf.data(), 1, buf.size(), in);
+	return end > 0;
+}
+/**
+ * @brief line
+ * @details Read up to the end of the line, which is dropped, as are carriage
+ * 			returns. Anything past 64K characters is dropped too.
+ * @return false at the end of the file
+ */
+bool Input::line(std::string & text){
+	text.clear();
+	int c = get();
+	if(c == EOF)
+		return false;
+	for(; c != EOF && c != '\n'; c = get()){
+		if(c != '\r' && text.size() < 65536)
+			text += static_cast<char>(c);
+	}
+	return true;
+}
+void Input::skipLine(){
+	int c;
+	while((c = get()) != EOF && c != '\n')
+		;
+}
+/**
+ * @brief Runs Object
+ * @details Joins runs that carry straight on from each other before handing them
+ * 			on, and drops those outside the rows wanted
+ */
+
+class Runs{
+	public:
+		Runs(const CellRun & put, long long y0, long long y1) : put(put), y0(y0), y1(y1), x(0), y(0), n(0) {}
+		~Runs() { flush(); }
+		void add(long long ax, long long ay, long long an){
+			if(ay < y0 || ay >= y1)
+				return;
+			if(n && ay == y && x + n == ax){
+				n += an;
+				return;
+			}
+			flush();
+			x = ax;
+			y = ay;
+			n = an;
+		}
+		void flush(){
+			if(n)
+				put(x, y, n);
+			n = 0;
+		}
+	private:
+		const CellRun & put;
+		long long y0, y1;
+		long long x, y, n;
+};
+
+/***************************************RLE FORMAT***************************************/
+
+/**
+ * @brief readRLE
+ * @details Run-length encoded cells: a count then b for dead, o (or any other
+ * 			letter, for multi-state files) for live, $ for the end of a row, ! for
+ * 			the end of the pattern. The header line gives the size and rule.
+ */
+static bool readRLE(Input & in, const CellRun & put, Pattern & info, long long y0, long long y1){
+	Runs runs(put, y0, y1);
+	long long x = 0, y = 0, n = 0, wide = 0;
+	bool start = true;
+	std::string text;
+	for(;;){
+		int c = in.get();
+		if(c == EOF || c == '!')
+			break;
+		if(start && (c == '#' || c == 'x')){
+			in.line(text);
+			text.insert(text.begin(), static_cast<char>(c));
+			if(text.compare(0, 2, "#r") == 0)
+				info.rule = text.substr(std::min(text.size(), text.find_first_not_of(" \t", 2)));
+			else if(c == 'x'){	//	x = 3, y = 3, rule = B3/S23
+				std::string key;
+				for(size_t i = 0; i < text.size(); i++){
+					size_t eq = text.find('=', i), comma = text.find(',', eq);
+					if(eq == std::string::npos)
+						break;
+					key.clear();
+					for(size_t j = i; j < eq; j++)
+						if(!std::isspace(static_cast<unsigned char>(text[j])))
+							key += text[j];
+					std::string val = text.substr(eq + 1, comma == std::string::npos ? std::string::npos : comma - eq - 1);
+					val.erase(0, val.find_first_not_of(" \t"));
+					val.erase(val.find_last_not_of(" \t") + 1);
+					if(key == "x")
+						info.wide = std::strtoll(val.c_str(), 0, 10);
+					else if(key == "y")
+						info.tall = std::strtoll(val.c_str(), 0, 10);
+					else if(key == "rule")
+						info.rule = val.substr(0, val.find(':'));	//	Golly adds :T for bounded grids
+					if(comma == std::string::npos)
+						break;
+					i = comma;
+				}
+			}
+			continue;
+		}
+		start = c == '\n';
+		if(c >= '0' && c <= '9'){
+			n = n * 10 + (c - '0');
+			if(n > MOST)
+				return false;
+			continue;
+		}
+		if(std::isspace(c))
+			continue;
+		long long k = n ? n : 1;
+		n = 0;
+		if(c == 'b' || c == '.')
+			x += k;
+		else if(c == '$'){
+			wide = std::max(wide, x);
+			y += k;
+			x = 0;
+			if(y >= y1)
+				break;
+		}
+		else if(std::isalpha(c)){
+			runs.add(x, y, k);
+			x += k;
+		}
+		else
+			return false;
+		if(x > MOST || y > MOST)
+			return false;
+	}
+	if(info.wide == 0 && info.tall == 0){
+		info.wide = std::max(wide, x);
+		info.tall = y + (x > 0);
+	}
+	return true;
+}
+/**
+ * @brief Writer Object
+ * @details RLE tokens into lines of at most 70 characters
+ */
+
+class Writer{
+	public:
+		Writer(std::FILE * out) : out(out) {}
+		void token(long long n, char c){
+			char tok[32];
+			int len = n > 1 ? std::snprintf(tok, sizeof(tok), "%lld%c", n, c) : std::snprintf(tok, sizeof(tok), "%c", c);
+			if(text.size() + len > 70)
+				flush();
+			text.append(tok, len);
+		}
+		void flush(){
+			if(!text.empty()){
+				text += '\n';
+				std::fwrite(text.data(), 1, text.size(), out);
+			}
+			text.clear();
+		}
+	private:
+		std::FILE * out;
+		std::string text;
+};
+/**
+ * @brief bounds
+ * @details Smallest box holding every live cell, false for a blank grid
+ */
+static bool bounds(const Grid & grid, long long & x0, long long & y0, long long & x1, long long & y1){
+	size_t n = grid.words();
+	x0 = y0 = MOST;
+	x1 = y1 = -1;
+	for(int y = 0; y < grid.height(); y++){
+		const uint64_t * row = grid.row(y);
+		for(size_t i = 0; i < n; i++){
+			uint64_t w = i + 1 < n ? row[i] : row[i] & grid.tailMask();
+			if(!w)
+				continue;
+			int hi = 63;
+			while(!(w >> hi & 1))
+				hi--;
+			x0 = std::min(x0, static_cast<long long>(i * 64 + lowest(w)));
+			x1 = std::max(x1, static_cast<long long>(i * 64 + hi));
+			y0 = std::min(y0, static_cast<long long>(y));
+			y1 = y;
+		}
+	}
+	return y1 >= 0;
+}
+/**
+ * @brief nextRun
+ * @details First run of live cells in a row at or after x, up to x1
+ * @return false if there are none
+ */
+static bool nextRun(const Grid & grid, int y, long long & x, long long & end, long long x1){
+	uint64_t w;
+	while(x <= x1 && (w = grid.bits(y, x)) == 0)
+		x += 64;
+	if(x > x1)
+		return false;
+	x += lowest(w);
+	if(x > x1)
+		return false;
+	end = x;
+	while((w = ~grid.bits(y, end)) == 0)
+		end += 64;
+	end = std::min(end + lowest(w), x1 + 1);
+	return true;
+}
+static bool writeRLE(std::FILE * out, const Grid & grid, const std::string & rule){
+	long long x0, y0, x1, y1;
+	if(!bounds(grid, x0, y0, x1, y1))
+		x0 = y0 = 0, x1 = y1 = -1;
+	std::fprintf(out, "x = %lld, y = %lld, rule = %s\n", x1 - x0 + 1, y1 - y0 + 1, rule.c_str());
+	Writer w(out);
+	long long rows = 0;
+	for(long long y = y0; y <= y1; y++){
+		long long x = x0, end, at = x0;
+		while(nextRun(grid, static_cast<int>(y), x, end, x1)){
+			if(rows){
+				w.token(rows, '$');
+				rows = 0;
+			}
+			if(x > at)
+				w.token(x - at, 'b');
+			w.token(end - x, 'o');
+			at = x = end;
+		}
+		rows++;
+	}
+	w.token(1, '!');
+	w.flush();
+	return true;
+}
+/***********************************End of RLE FORMAT************************************/
+
+
+/**************************************PLAIN FORMAT**************************************/
+
+/**
+ * @brief readPlain
+ * @details Plaintext cells: a line per row, . for dead and O for live, lines
+ * 			starting with ! are comments
+ */
+static bool readPlain(Input & in, const CellRun & put, Pattern & info, long long y0, long long y1){
+	Runs runs(put, y0, y1);
+	long long x = 0, y = 0;
+	bool start = true;
+	for(int c = in.get(); c != EOF && y < y1; c = in.get()){
+		if(start && c == '!'){
+			in.skipLine();
+			continue;
+		}
+		start = c == '\n';
+		if(c == '\n'){
+			info.wide = std::max(info.wide, x);
+			y++;
+			x = 0;
+		}
+		else if(c == 'O' || c == 'o' || c == '*')
+			runs.add(x++, y, 1);
+		else if(c == '.')
+			x++;
+		else if(!std::isspace(c))
+			return false;
+	}
+	info.wide = std::max(info.wide, x);
+	info.tall = y + (x > 0);
+	return true;
+}
+static bool writePlain(std::FILE * out, const Grid & grid){
+	long long x0, y0, x1, y1;
+	std::fprintf(out, "!Name: life\n");
+	if(!bounds(grid, x0, y0, x1, y1))
+		return true;
+	std::string line;
+	for(long long y = y0; y <= y1; y++){
+		line.clear();
+		long long x = x0, end;
+		while(nextRun(grid, static_cast<int>(y), x, end, x1)){
+			line.append(static_cast<size_t>(x - x0) - line.size(), '.');
+			line.append(static_cast<size_t>(end - x), 'O');
+			x = end;
+		}
+		line += '\n';
+		std::fwrite(line.data(), 1, line.size(), out);
+	}
+	return true;
+}
+/**********************************End of PLAIN FORMAT***********************************/
+
+
+/************************************MACROCELL FORMAT************************************/
+
+/**
+ * @brief Tree Object
+ * @details The nodes of a Macrocell file. Node 0 is the empty node of any size; a
+ * 			level 3 node is an 8x8 leaf, row r in byte r with cell x in bit x; a
+ * 			node above that is four nodes a level down. Each node also carries the
+ * 			box of its live cells, in its own coordinates.
+ */
+
+struct Tree{
+	struct Node{
+		uint64_t bits;
+		uint32_t q[4];			//	nw, ne, sw, se
+		int level;
+		long long x0, y0, x1, y1;	//	live cells, x1 < x0 if none
+	};
+	std::vector<Node> nodes;
+	void walk(uint32_t n, long long x, long long y, Runs & runs, long long cx0, long long cy0, long long cx1, long long cy1) const;
+};
+/**
+ * @brief walk
+ * @details Hand on the live cells of a node whose top left is at (x,y), leaving
+ * 			out nodes wholly outside the clip box
+ */
+void Tree::walk(uint32_t n, long long x, long long y, Runs & runs, long long cx0, long long cy0, long long cx1, long long cy1) const{
+	const Node & d = nodes[n];
+	if(n == 0 || x + d.x1 < cx0 || y + d.y1 < cy0 || x + d.x0 >= cx1 || y + d.y0 >= cy1)
+		return;
+	if(d.level == 3){
+		for(int r = 0; r < 8; r++){
+			unsigned row = static_cast<unsigned>(d.bits >> (8 * r)) & 0xff;
+			while(row){
+				int s = lowest(row), e = s;
+				while(e < 8 && (row >> e & 1))
+					e++;
+				runs.add(x + s, y + r, e - s);
+				row &= ~((1u << e) - 1);
+			}
+		}
+		return;
+	}
+	long long h = 1LL << (d.level - 1);
+	walk(d.q[0], x, y, runs, cx0, cy0, cx1, cy1);
+	walk(d.q[1], x + h, y, runs, cx0, cy0, cx1, cy1);
+	walk(d.q[2], x, y + h, runs, cx0, cy0, cx1, cy1);
+	walk(d.q[3], x + h, y + h, runs, cx0, cy0, cx1, cy1);
+}
+/**
+ * @brief readMacrocell
+ * @details [M2] header, #R rule, then a node a line: a leaf as rows of . and *
+ * 			ended by $, or "level nw ne sw se" with the numbers of earlier lines
+ */
+static bool readMacrocell(Input & in, const CellRun & put, Pattern & info, long long x0, long long y0, long long x1, long long y1){
+	Tree tree;
+	Tree::Node blank = { 0, { 0, 0, 0, 0 }, 0, 0, 0, -1, -1 };
+	tree.nodes.push_back(blank);
+	std::string text;
+	if(!in.line(text) || text.compare(0, 4, "[M2]") != 0)
+		return false;
+	while(in.line(text)){
+		if(text.empty())
+			continue;
+		if(text[0] == '#'){
+			if(text.size() > 1 && (text[1] == 'R' || text[1] == 'r'))
+				info.rule = text.substr(std::min(text.size(), text.find_first_not_of(" \t", 2)));
+			continue;
+		}
+		Tree::Node d = blank;
+		if(text[0] == '.' || text[0] == '*' || text[0] == '$'){
+			int r = 0, c = 0;
+			for(size_t i = 0; i < text.size(); i++){
+				if(text[i] == '$'){
+					r++;
+					c = 0;
+				}
+				else if(r < 8 && c < 8){
+					if(text[i] == '*')
+						d.bits |= 1ULL << (8 * r + c);
+					c++;
+				}
+				else
+					return false;
+			}
+			d.level = 3;
+			d.x0 = d.y0 = d.bits ? 8 : 0;
+			for(int i = 0; i < 64; i++){
+				if(d.bits >> i & 1){
+					d.x0 = std::min(d.x0, static_cast<long long>(i % 8));
+					d.x1 = std::max(d.x1, static_cast<long long>(i % 8));
+					d.y0 = std::min(d.y0, static_cast<long long>(i / 8));
+					d.y1 = i / 8;
+				}
+			}
+		}
+		else{
+			char * p = &text[0];
+			d.level = static_cast<int>(std::strtol(p, &p, 10));
+			if(d.level < 4 || d.level > 62)
+				return false;
+			long long h = 1LL << (d.level - 1);
+			for(int k = 0; k < 4; k++){
+				unsigned long long q = std::strtoull(p, &p, 10);
+				if(q >= tree.nodes.size() || (q && tree.nodes[q].level != d.level - 1))
+					return false;
+				d.q[k] = static_cast<uint32_t>(q);
+				const Tree::Node & c = tree.nodes[q];
+				if(c.x1 < c.x0)
+					continue;
+				long long ox = k & 1 ? h : 0, oy = k & 2 ? h : 0;
+				d.x0 = d.x1 < d.x0 ? c.x0 + ox : std::min(d.x0, c.x0 + ox);
+				d.y0 = d.y1 < d.y0 ? c.y0 + oy : std::min(d.y0, c.y0 + oy);
+				d.x1 = std::max(d.x1, c.x1 + ox);
+				d.y1 = std::max(d.y1, c.y1 + oy);
+			}
+		}
+		tree.nodes.push_back(d);
+	}
+	uint32_t root = static_cast<uint32_t>(tree.nodes.size() - 1);
+	const Tree::Node & top = tree.nodes[root];
+	if(root == 0 || top.x1 < top.x0)
+		return true;
+	info.wide = top.x1 - top.x0 + 1;
+	info.tall = top.y1 - top.y0 + 1;
+	Runs runs(put, y0, y1);
+	tree.walk(root, -top.x0, -top.y0, runs, x0, y0, x1, y1);
+	return true;
+}
+/**
+ * @brief Cells Object
+ * @details Builds the Macrocell tree of a grid, writing each distinct node the
+ * 			first time it turns up so children always come before their parents
+ */
+
+class Cells{
+	public:
+		Cells(std::FILE * out, const Grid & grid, long long x0, long long y0, long long x1, long long y1)
+				: out(out), grid(grid), x0(x0), y0(y0), x1(x1), y1(y1), count(0) {}
+		uint32_t build(int level, long long x, long long y);
+	private:
+		struct Key{
+			uint32_t q[4];
+			int level;
+			bool operator==(const Key & k) const { return level == k.level && std::memcmp(q, k.q, sizeof(q)) == 0; }
+		};
+		struct Hash{
+			size_t operator()(const Key & k) const{
+				uint64_t h = k.level;
+				for(int i = 0; i < 4; i++)
+					h = (h ^ k.q[i]) * 0x9e3779b97f4a7c15ULL;
+				return static_cast<size_t>(h ^ (h >> 29));
+			}
+		};
+		std::FILE * out;
+		const Grid & grid;
+		long long x0, y0, x1, y1;
+		uint32_t count;
+		std::unordered_map<uint64_t, uint32_t> leaves;
+		std::unordered_map<Key, uint32_t, Hash> nodes;
+};
+uint32_t Cells::build(int level, long long x, long long y){
+	long long size = 1LL << level;
+	if(x > x1 || y > y1 || x + size <= x0 || y + size <= y0)
+		return 0;
+	if(level == 3){
+		uint64_t bits = 0;
+		for(int r = 0; r < 8; r++){
+			if(y + r <= y1)
+				bits |= (grid.bits(static_cast<int>(y + r), x) & 0xff) << (8 * r);
+		}
+		if(!bits)
+			return 0;
+		std::unordered_map<uint64_t, uint32_t>::iterator it = leaves.find(bits);
+		if(it != leaves.end())
+			return it->second;
+		std::string text;
+		int rows = 8;
+		while(!(bits >> (8 * (rows - 1)) & 0xff))
+			rows--;
+		for(int r = 0; r < rows; r++){
+			unsigned row = static_cast<unsigned>(bits >> (8 * r)) & 0xff;
+			for(int c = 0; row >> c; c++)
+				text += row >> c & 1 ? '*' : '.';
+			text += '$';
+		}
+		text += '\n';
+		std::fwrite(text.data(), 1, text.size(), out);
+		return leaves[bits] = ++count;
+	}
+	long long h = size / 2;
+	Key k;
+	k.level = level;
+	k.q[0] = build(level - 1, x, y);
+	k.q[1] = build(level - 1, x + h, y);
+	k.q[2] = build(level - 1, x, y + h);
+	k.q[3] = build(level - 1, x + h, y + h);
+	if(!(k.q[0] | k.q[1] | k.q[2] | k.q[3]))
+		return 0;
+	std::unordered_map<Key, uint32_t, Hash>::iterator it = nodes.find(k);
+	if(it != nodes.end())
+		return it->second;
+	std::fprintf(out, "%d %u %u %u %u\n", level, k.q[0], k.q[1], k.q[2], k.q[3]);
+	return nodes[k] = ++count;
+}
+static bool writeMacrocell(std::FILE * out, const Grid & grid, const std::string & rule){
+	std::fprintf(out, "[M2] (life)\n#R %s\n", rule.c_str());
+	long long x0, y0, x1, y1;
+	if(!bounds(grid, x0, y0, x1, y1))
+		return true;
+	int level = 3;
+	while((1LL << level) < std::max(x1 - x0 + 1, y1 - y0 + 1))
+		level++;
+	Cells cells(out, grid, x0, y0, x1, y1);
+	cells.build(level, x0, y0);
+	return true;
+}
+/********************************End of MACROCELL FORMAT*********************************/
+
+
+/**
+ * @brief patternFormat
+ * @details Format a file name's extension stands for: .rle, .cells or .txt, .mc
+ */
+Pattern::Format patternFormat(const std::string & path){
+	std::string ext = path.substr(std::min(path.size(), path.rfind('.')));
+	for(size_t i = 0; i < ext.size(); i++)
+		ext[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(ext[i])));
+	if(ext == ".rle")
+		return Pattern::RLE;
+	if(ext == ".cells" || ext == ".txt")
+		return Pattern::PLAIN;
+	if(ext == ".mc")
+		return Pattern::MACROCELL;
+	return Pattern::UNKNOWN;
+}
+/**
+ * @brief readPattern
+ * @details Read a pattern file of any of the formats, told apart by what the file
+ * 			starts with, handing its live cells on as runs. The clip box is only a
+ * 			hint: rows past it stop the read and Macrocell nodes outside it are
+ * 			skipped, but runs poking out of it still come through.
+ * @param path file to read
+ * @param put called for each run of live cells
+ * @param info set to what the file says about itself
+ * @param x0 left of the cells wanted
+ * @param y0 top of the cells wanted
+ * @param x1 one past the right of the cells wanted
+ * @param y1 one past the bottom of the cells wanted
+ * @return false if the file couldn't be read or isn't a pattern
+ */
+bool readPattern(const std::string & path, const CellRun & put, Pattern * info,
+		long long x0, long long y0, long long x1, long long y1){
+	Pattern own;
+	Pattern & p = info ? *info : own;
+	p = Pattern();
+	std::FILE * in = std::fopen(path.c_str(), "rb");
+	if(!in)
+		return false;
+	Input input(in);
+	int c = input.peek();
+	if(c == '[')
+		p.format = Pattern::MACROCELL;
+	else if(c == '!' || c == '.' || c == 'O' || c == '*')
+		p.format = Pattern::PLAIN;
+	else if(c == '#' || c == 'x')
+		p.format = Pattern::RLE;
+	else
+		p.format = patternFormat(path);
+	bool ok = false;
+	switch(p.format){
+		case Pattern::RLE:			ok = readRLE(input, put, p, y0, y1); break;
+		case Pattern::PLAIN:		ok = readPlain(input, put, p, y0, y1); break;
+		case Pattern::MACROCELL:	ok = readMacrocell(input, put, p, x0, y0, x1, y1); break;
+		default:					break;
+	}
+	ok = !std::ferror(in) && ok;
+	std::fclose(in);
+	return ok;
+}
+/**
+ * @brief placePattern
+ * @details Paste a pattern over a grid with its top left at (x,y). Live cells of
+ * 			the pattern are brought to life, the rest of the grid is left as it
+ * 			is, and whatever falls off the grid is dropped.
+ */
+bool placePattern(const std::string & path, Engine & engine, long long x, long long y, Pattern * info){
+	return readPattern(path, [&engine, x, y](long long px, long long py, long long n){
+		engine.setRun(x + px, y + py, n);
+	}, info, -x, -y, engine.width() - x, engine.height() - y);
+}
+/**
+ * @brief placePattern
+ * @details Paste a pattern into an unbounded world with its top left at (x,y)
+ */
+bool placePattern(const std::string & path, World & world, long long x, long long y, Pattern * info){
+	return readPattern(path, [&world, x, y](long long px, long long py, long long n){
+		world.setRun(x + px, y + py, n);
+	}, info);
+}
+/**
+ * @brief writePattern
+ * @details Write the live cells of a grid, trimmed to the box around them
+ * @param path file to write
+ * @param grid cells to write
+ * @param format RLE, PLAIN or MACROCELL
+ * @param rule rule to name in the file, where the format has room for one
+ * @return false if the file couldn't be written
+ */
+bool writePattern(const std::string & path, const Grid & grid, Pattern::Format format, const std::string & rule){
+	if(format == Pattern::UNKNOWN)
+		return false;
+	std::FILE * out = std::fopen(path.c_str(), "wb");
+	if(!out)
+		return false;
+	bool ok = false;
+	switch(format){
+		case Pattern::RLE:			ok = writeRLE(out, grid, rule); break;
+		case Pattern::PLAIN:		ok = writePlain(out, grid); break;
+		case Pattern::MACROCELL:	ok = writeMacrocell(out, grid, rule); break;
+		default:					break;
+	}
+	ok = !std::ferror(out) && ok;
+	ok = std::fclose(out) == 0 && ok;
+	if(!ok)
+		std::remove(path.c_str());
+	return ok;
+}
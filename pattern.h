@@ -0,0 +1,48 @@
+/**
+ * Conway's Game of Life simulation - pattern files
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_PATTERN_H
+#define LIFE_PATTERN_H
+
+#include "engine.h"
+#include "world.h"
+#include <string>
+#include <functional>
+#include <climits>
+
+/**
+ * @brief Pattern Object
+ * @details What a pattern file says about itself. RLE and plaintext (.cells) files
+ * 			are read a buffer at a time and their cells handed on as runs as they
+ * 			go by, so a file of any size reads in a fixed amount of memory.
+ * 			Macrocell files are a quadtree whose nodes refer back to earlier
+ * 			ones, so their nodes are kept (never their cells); the tree is then
+ * 			walked to hand on the runs. Pattern coordinates put the top left live
+ * 			cell of a Macrocell pattern, or the top left of an RLE or plaintext
+ * 			one, at (0,0).
+ */
+
+struct Pattern{
+	enum Format{ UNKNOWN, RLE, PLAIN, MACROCELL };
+	Pattern() : format(UNKNOWN), wide(0), tall(0) {}
+	Format format;
+	long long wide, tall;			//	size given in the file, or of the cells read
+	std::string rule;				//	rule given in the file, empty if none
+};
+
+typedef std::function<void(long long x, long long y, long long n)> CellRun;	//	n live cells from (x,y) rightward
+
+Pattern::Format patternFormat(const std::string & path);
+bool readPattern(const std::string & path, const CellRun & put, Pattern * info = 0,
+		long long x0 = LLONG_MIN, long long y0 = LLONG_MIN, long long x1 = LLONG_MAX, long long y1 = LLONG_MAX);
+bool placePattern(const std::string & path, Engine & engine, long long x, long long y, Pattern * info = 0);
+bool placePattern(const std::string & path, World & world, long long x, long long y, Pattern * info = 0);
+bool writePattern(const std::string & path, const Grid & grid, Pattern::Format format, const std::string & rule);
+
+#endif
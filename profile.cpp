@@ -0,0 +1,155 @@
+/**
+ * Conway's Game of Life simulation - profiling
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "profile.h"
+#include <algorithm>
+#include <cstdio>
+
+/************************************HISTOGRAM CLASS*************************************/
+
+Histogram::Histogram() : total(0), most(0){
+	std::fill(counts, counts + BUCKETS, 0);
+}
+/**
+ * @brief add
+ * @details Merge in another histogram, such as another thread's
+ */
+void Histogram::add(const Histogram & other){
+	for(int b = 0; b < BUCKETS; b++)
+		counts[b] += other.counts[b];
+	total += other.total;
+	most = std::max(most, other.most);
+}
+/**
+ * @brief subtract
+ * @details Take away an earlier reading of the same counters, leaving what was
+ * 			recorded in between
+ */
+void Histogram::subtract(const Histogram & other){
+	for(int b = 0; b < BUCKETS; b++)
+		counts[b] -= other.counts[b];
+	total -= other.total;
+}
+uint64_t Histogram::count() const{
+	uint64_t n = 0;
+	for(int b = 0; b < BUCKETS; b++)
+		n += counts[b];
+	return n;
+}
+/**
+ * @brief mean
+ * @details Average time in nanoseconds, 0 if nothing was recorded
+ */
+double Histogram::mean() const{
+	uint64_t n = count();
+	return n ? static_cast<double>(total) / n : 0;
+}
+/**
+ * @brief percentile
+ * @details Time in nanoseconds that a fraction p of the recorded times are at or
+ * 			under, as the middle of the bucket it falls in
+ * @param p fraction, 0 to 1
+ */
+double Histogram::percentile(double p) const{
+	uint64_t n = count();
+	if(n == 0)
+		return 0;
+	uint64_t want = std::max<uint64_t>(1, static_cast<uint64_t>(p * n + 0.5)), seen = 0;
+	for(int b = 0; b < BUCKETS; b++){
+		seen += counts[b];
+		if(seen < want)
+			continue;
+		if(b < SUB)
+			return b;
+		int top = b / SUB + 2;
+		double low = static_cast<double>((SUB + b % SUB)) * static_cast<double>(1ULL << (top - 3));
+		return low + static_cast<double>(1ULL << (top - 3)) / 2;
+	}
+	return static_cast<double>(most);
+}
+/********************************End of HISTOGRAM CLASS*********************************/
+
+
+/*************************************PROFILE CLASS**************************************/
+
+Profile::Counters::Counters() : next(0){
+	for(int p = 0; p < PROBES; p++){
+		for(int b = 0; b < Histogram::BUCKETS; b++)
+			counts[p][b].store(0, std::memory_order_relaxed);
+		total[p].store(0, std::memory_order_relaxed);
+		most[p].store(0, std::memory_order_relaxed);
+	}
+}
+/**
+ * @brief threads
+ * @details Head of the list of every thread's counters
+ */
+std::atomic<Profile::Counters *> & Profile::threads(){
+	static std::atomic<Counters *> head(0);
+	return head;
+}
+/**
+ * @brief local
+ * @details This thread's counters, made and pushed onto the list the first time.
+ * 			They outlive the thread, so nothing it recorded is lost.
+ */
+Profile::Counters & Profile::local(){
+	static thread_local Counters * mine = 0;
+	if(!mine){
+		mine = new Counters();
+		Counters * head = threads().load(std::memory_order_relaxed);
+		do
+			mine->next = head;
+		while(!threads().compare_exchange_weak(head, mine, std::memory_order_release, std::memory_order_relaxed));
+	}
+	return *mine;
+}
+const char * Profile::name(Probe probe){
+	static const char * names[PROBES] = { "step", "band", "render", "input", "snapshot" };
+	return names[probe];
+}
+/**
+ * @brief read
+ * @details Everything recorded for a probe so far, over every thread
+ */
+Histogram Profile::read(Probe probe){
+	Histogram h;
+	for(Counters * c = threads().load(std::memory_order_acquire); c; c = c->next){
+		for(int b = 0; b < Histogram::BUCKETS; b++)
+			h.counts[b] += c->counts[probe][b].load(std::memory_order_relaxed);
+		h.total += c->total[probe].load(std::memory_order_relaxed);
+		h.most = std::max(h.most, c->most[probe].load(std::memory_order_relaxed));
+	}
+	return h;
+}
+/**
+ * @brief write
+ * @details Write a line of JSON per probe: how many times it ran, the mean and
+ * 			its percentiles, in microseconds
+ * @param path file to write
+ * @return false if the file couldn't be written
+ */
+bool Profile::write(const std::string & path){
+	std::FILE * out = std::fopen(path.c_str(), "w");
+	if(!out)
+		return false;
+	bool ok = std::fprintf(out, "{\"enabled\": %s, \"probes\": [\n", LIFE_PROFILE ? "true" : "false") > 0;
+	for(int p = 0; p < PROBES; p++){
+		Histogram h = read(static_cast<Probe>(p));
+		ok = ok && std::fprintf(out, "  {\"probe\": \"%s\", \"count\": %llu, \"total_us\": %.3f, \"mean_us\": %.3f, "
+				"\"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+				name(static_cast<Probe>(p)), static_cast<unsigned long long>(h.count()), h.total / 1e3, h.mean() / 1e3,
+				h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3, h.percentile(0.99) / 1e3, h.most / 1e3,
+				p + 1 < PROBES ? "," : "") > 0;
+	}
+	ok = ok && std::fprintf(out, "]}\n") > 0;
+	ok = (std::fclose(out) == 0) && ok;
+	return ok;
+}
+/*********************************End of PROFILE CLASS***********************************/
@@ -0,0 +1,121 @@
+/**
+ * Conway's Game of Life simulation - profiling
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_PROFILE_H
+#define LIFE_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+#ifndef LIFE_PROFILE
+#define LIFE_PROFILE 1				//	build with -DLIFE_PROFILE=0 and the timers compile to nothing
+#endif
+
+/**
+ * @brief Histogram Object
+ * @details Durations in nanoseconds. Times under 8ns get a bucket each; above that
+ * 			each power of two is split into 8 buckets by the three bits below the
+ * 			top one, so any time is placed to within 12.5% in 512 buckets.
+ */
+
+struct Histogram{
+	enum{ SUB = 8, BUCKETS = 64 * SUB };
+	Histogram();
+	void add(const Histogram & other);
+	void subtract(const Histogram & other);
+	uint64_t count() const;
+	double mean() const;
+	double percentile(double p) const;
+	static int bucket(uint64_t ns){
+		if(ns < SUB)
+			return static_cast<int>(ns);
+#if defined(__GNUC__)
+		int top = 63 - __builtin_clzll(ns);
+#else
+		int top = 3;
+		while(ns >> (top + 1))
+			top++;
+#endif
+		return (top - 2) * SUB + static_cast<int>((ns >> (top - 3)) & (SUB - 1));
+	}
+	uint64_t counts[BUCKETS];
+	uint64_t total;					//	sum of the times
+	uint64_t most;					//	longest time, kept as is by subtract()
+};
+
+/**
+ * @brief Profile
+ * @details Where the time goes, per probe. Each thread records into histograms of
+ * 			its own, linked once onto a list the first time it records, so
+ * 			recording takes no locks and no lock-prefixed instructions: the owner
+ * 			is the only writer and readers just add up what they see.
+ */
+
+struct Profile{
+	enum Probe{ STEP, BAND, RENDER, INPUT, SNAPSHOT, PROBES };
+	static const char * name(Probe probe);
+	static void record(Probe probe, uint64_t ns);
+	static Histogram read(Probe probe);
+	static bool write(const std::string & path);
+	private:
+		struct Counters{
+			Counters();
+			std::atomic<uint64_t> counts[PROBES][Histogram::BUCKETS];
+			std::atomic<uint64_t> total[PROBES];
+			std::atomic<uint64_t> most[PROBES];
+			Counters * next;
+		};
+		static Counters & local();
+		static std::atomic<Counters *> & threads();
+};
+
+inline void Profile::record(Probe probe, uint64_t ns){
+#if LIFE_PROFILE
+	Counters & mine = local();
+	std::atomic<uint64_t> & c = mine.counts[probe][Histogram::bucket(ns)];
+	c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	mine.total[probe].store(mine.total[probe].load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+	if(ns > mine.most[probe].load(std::memory_order_relaxed))
+		mine.most[probe].store(ns, std::memory_order_relaxed);
+#else
+	(void)probe;
+	(void)ns;
+#endif
+}
+
+/**
+ * @brief ScopedTimer Object
+ * @details Records the time from its construction to the end of its scope
+ */
+
+class ScopedTimer{
+	public:
+		explicit ScopedTimer(Profile::Probe probe) : probe(probe), began(std::chrono::steady_clock::now()) {}
+		~ScopedTimer(){
+			Profile::record(probe, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - began).count()));
+		}
+	private:
+		ScopedTimer(const ScopedTimer &);
+		ScopedTimer & operator=(const ScopedTimer &);
+		Profile::Probe probe;
+		std::chrono::steady_clock::time_point began;
+};
+
+#define LIFE_JOIN2(a, b) a##b
+#define LIFE_JOIN(a, b) LIFE_JOIN2(a, b)
+#if LIFE_PROFILE
+#define LIFE_TIME(probe) ScopedTimer LIFE_JOIN(timer, __LINE__)(Profile::probe)
+#else
+#define LIFE_TIME(probe) ((void)0)
+#endif
+
+#endif
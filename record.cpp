@@ -0,0 +1,259 @@
+/**
+ * Conway's Game of Life simulation - run logs
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "record.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+
+static const char MAGIC[8] = { 'L', 'I', 'F', 'E', 'L', 'O', 'G', '1' };
+
+/*************************************RECORDER CLASS*************************************/
+
+Recorder::Recorder() : out(0), every(1000), keyed(0), now(0), ok(false){
+}
+Recorder::~Recorder(){
+	close();
+}
+/**
+ * @brief open
+ * @details Start a new log of an engine, beginning with a keyframe of its cells
+ * @param path file to write, replaced if it exists
+ * @param engine engine to record
+ * @param interval generations between keyframes
+ * @return false if the file couldn't be written
+ */
+bool Recorder::open(const std::string & path, const Engine & engine, unsigned interval){
+	close();
+	out = std::fopen(path.c_str(), "wb");
+	if(!out)
+		return false;
+	LogHeader h;
+	std::memset(&h, 0, sizeof(h));
+	std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = LogHeader::VERSION;
+	h.topology = engine.topology();
+	h.wide = engine.width();
+	h.tall = engine.height();
+	h.birth = engine.rule().birth;
+	h.survive = engine.rule().survive;
+	h.generation = engine.generation();
+	h.seed = engine.seed();
+	h.interval = every = std::max(1u, interval);
+	shadow = Grid(engine.width(), engine.height());
+	ok = std::fwrite(&h, sizeof(h), 1, out) == 1;
+	return key(engine);
+}
+/**
+ * @brief step
+ * @details Log the generation just stepped: the words that changed, or a whole
+ * 			keyframe once one is due
+ */
+bool Recorder::step(const Engine & engine){
+	if(!out)
+		return false;
+	if(engine.generation() - keyed >= every)
+		return key(engine);
+	return delta(engine, LogRecord::STEP);
+}
+/**
+ * @brief edit
+ * @details Log cells changed between generations, such as a blob or a pasted
+ * 			pattern
+ */
+bool Recorder::edit(const Engine & engine){
+	if(!out)
+		return false;
+	return delta(engine, LogRecord::EDIT);
+}
+/**
+ * @brief close
+ * @details Mark the generation the run got to and finish the file
+ * @return false if any of the log couldn't be written
+ */
+bool Recorder::close(){
+	if(!out)
+		return false;
+	record(LogRecord::END, now, 0, 0);
+	ok = (std::fclose(out) == 0) && ok;
+	out = 0;
+	return ok;
+}
+/**
+ * @brief key
+ * @details Write every cell, packed, and start comparing against them afresh
+ */
+bool Recorder::key(const Engine & engine){
+	const Grid & grid = engine.cells();
+	if(grid.width() != shadow.width() || grid.height() != shadow.height())
+		return ok = false;
+	LogRecord r;
+	std::memset(&r, 0, sizeof(r));
+	r.kind = LogRecord::KEY;
+	r.generation = keyed = now = engine.generation();
+	long at = std::ftell(out);
+	ok = ok && at >= 0 && std::fwrite(&r, sizeof(r), 1, out) == 1;
+	ok = ok && packCells(out, grid, r.bytes);
+	ok = ok && std::fseek(out, at, SEEK_SET) == 0 && std::fwrite(&r, sizeof(r), 1, out) == 1;
+	ok = ok && std::fseek(out, 0, SEEK_END) == 0;
+	size_t n = grid.words();
+	for(int y = 0; y < grid.height() && n; y++){
+		std::memcpy(shadow.row(y), grid.row(y), n * sizeof(uint64_t));
+		shadow.row(y)[n-1] &= grid.tailMask();
+	}
+	return ok;
+}
+/**
+ * @brief delta
+ * @details Compare the tiles flagged as changed against the cells last written
+ * 			and log the words that differ
+ */
+bool Recorder::delta(const Engine & engine, LogRecord::Kind kind){
+	const Grid & grid = engine.cells();
+	const Activity & act = engine.tiles();
+	if(grid.width() != shadow.width() || grid.height() != shadow.height())
+		return ok = false;
+	size_t n = grid.words();
+	uint64_t tail = grid.tailMask();
+	changes.clear();
+	for(int ty = 0; ty < act.down(); ty++){
+		int y0 = ty * TILE_ROWS;
+		int y1 = std::min(y0 + TILE_ROWS, grid.height());
+		for(int tx = 0; tx < act.across(); tx++){
+			if(!act.changed(tx, ty))
+				continue;
+			size_t w0 = static_cast<size_t>(tx) * TILE_WORDS;
+			size_t w1 = std::min(w0 + TILE_WORDS, n);
+			for(int y = y0; y < y1; y++){
+				const uint64_t * row = grid.row(y);
+				uint64_t * mine = shadow.row(y);
+				for(size_t i = w0; i < w1; i++){
+					uint64_t w = i + 1 < n ? row[i] : row[i] & tail;
+					if(w != mine[i]){
+						changes.push_back(static_cast<uint64_t>(y) * n + i);
+						changes.push_back(w ^ mine[i]);
+						mine[i] = w;
+					}
+				}
+			}
+		}
+	}
+	now = engine.generation();
+	if(changes.empty())
+		return ok;
+	return record(kind, now, changes.data(), changes.size() * sizeof(uint64_t));
+}
+/**
+ * @brief record
+ * @details Append one record and its body
+ */
+bool Recorder::record(LogRecord::Kind kind, uint64_t generation, const void * body, uint64_t bytes){
+	LogRecord r;
+	std::memset(&r, 0, sizeof(r));
+	r.kind = kind;
+	r.generation = generation;
+	r.bytes = bytes;
+	ok = ok && std::fwrite(&r, sizeof(r), 1, out) == 1;
+	ok = ok && (bytes == 0 || std::fwrite(body, 1, bytes, out) == bytes);
+	return ok;
+}
+/*********************************End of RECORDER CLASS**********************************/
+
+
+/**************************************REPLAY CLASS**************************************/
+
+/**
+ * @brief open
+ * @details Check a log's header and index its records. A log cut short, by a crash
+ * 			say, is read up to its last whole record.
+ * @param path file to read
+ * @return false if the file is missing or not a run log
+ */
+bool Replay::open(const std::string & path){
+	index.clear();
+	this->path = path;
+	std::FILE * in = std::fopen(path.c_str(), "rb");
+	if(!in)
+		return false;
+	long size = -1;
+	if(std::fseek(in, 0, SEEK_END) == 0)
+		size = std::ftell(in);
+	bool ok = size >= 0 && std::fseek(in, 0, SEEK_SET) == 0 && std::fread(&head, sizeof(head), 1, in) == 1
+			&& std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) == 0 && head.version == LogHeader::VERSION && head.topology <= 3
+			&& head.wide > 0 && head.tall > 0 && head.wide <= (1u << 30) && head.tall <= (1u << 30)
+			&& rules.assign(head.birth, head.survive);
+	Entry e;
+	while(ok && std::fread(&e.record, sizeof(e.record), 1, in) == 1){
+		e.offset = std::ftell(in);
+		if(e.offset < 0 || e.record.bytes > static_cast<uint64_t>(size - e.offset) || e.record.kind > LogRecord::END
+				|| (!index.empty() && e.record.generation < index.back().record.generation))
+			break;
+		index.push_back(e);
+		if(std::fseek(in, static_cast<long>(e.offset + e.record.bytes), SEEK_SET) != 0)
+			break;
+	}
+	std::fclose(in);
+	ok = ok && !index.empty() && index[0].record.kind == LogRecord::KEY;
+	end = ok ? index.back().record.generation : 0;
+	return ok;
+}
+/**
+ * @brief seek
+ * @details Rebuild the cells as they were at a generation, after any edits made
+ * 			during it
+ * @param generation generation wanted, from first() to last()
+ * @param threads stepping threads for the engine, 0 for one per core
+ * @return an engine carrying on from there, null if the generation isn't in the
+ * 			log or the log is damaged
+ */
+std::unique_ptr<Engine> Replay::seek(unsigned long long generation, int threads) const{
+	std::unique_ptr<Engine> engine;
+	if(index.empty() || generation < first() || generation > last())
+		return engine;
+	size_t k = 0;
+	for(size_t i = 0; i < index.size() && index[i].record.generation <= generation; i++){
+		if(index[i].record.kind == LogRecord::KEY)
+			k = i;
+	}
+	std::FILE * in = std::fopen(path.c_str(), "rb");
+	if(!in)
+		return engine;
+	Grid grid(static_cast<int>(head.wide), static_cast<int>(head.tall));
+	size_t n = grid.words();
+	uint64_t total = static_cast<uint64_t>(n) * grid.height();
+	std::vector<unsigned char> body(static_cast<size_t>(index[k].record.bytes));
+	bool ok = std::fseek(in, index[k].offset, SEEK_SET) == 0
+			&& (body.empty() || std::fread(body.data(), 1, body.size(), in) == body.size())
+			&& unpackCells(body.data(), body.data() + body.size(), grid);
+	std::vector<uint64_t> pairs(1 << 16);
+	for(size_t i = k + 1; ok && i < index.size() && index[i].record.generation <= generation; i++){
+		const LogRecord & r = index[i].record;
+		if(r.kind != LogRecord::STEP && r.kind != LogRecord::EDIT)
+			continue;
+		ok = r.bytes % 16 == 0 && std::fseek(in, index[i].offset, SEEK_SET) == 0;
+		for(uint64_t left = r.bytes / 8; ok && left > 0; ){
+			size_t got = static_cast<size_t>(std::min<uint64_t>(left, pairs.size()));
+			ok = std::fread(pairs.data(), sizeof(uint64_t), got, in) == got;
+			for(size_t j = 0; ok && j < got; j += 2){
+				ok = pairs[j] < total;
+				if(ok)
+					grid.row(static_cast<int>(pairs[j] / n))[pairs[j] % n] ^= pairs[j+1];
+			}
+			left -= got;
+		}
+	}
+	std::fclose(in);
+	if(!ok)
+		return engine;
+	for(int y = 0; y < grid.height() && n; y++)
+		grid.row(y)[n-1] &= grid.tailMask();
+	engine.reset(new Engine(std::move(grid), rules, head.topology, threads, generation, static_cast<unsigned>(head.seed)));
+	return engine;
+}
+/**********************************End of REPLAY CLASS***********************************/
@@ -0,0 +1,111 @@
+/**
+ * Conway's Game of Life simulation - run logs
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_RECORD_H
+#define LIFE_RECORD_H
+
+#include "engine.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+
+/**
+ * @brief Log Header
+ * @details First 64 bytes of a run log, in the byte order of the machine that
+ * 			wrote it, like the records and words after it. Records follow, each a
+ * 			LogRecord and then its body: a keyframe holds every cell word packed as
+ * 			in an RLE snapshot, a step or edit holds the words that changed as
+ * 			pairs of word index (row * words per row + word) and the bits that
+ * 			flipped. Generations whose step changed nothing aren't written.
+ */
+
+struct LogHeader{
+	enum{ VERSION = 1 };
+	char magic[8];					//	"LIFELOG1"
+	uint32_t version;
+	uint32_t topology;				//	edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+	uint32_t wide, tall;			//	grid size in cells
+	uint32_t birth, survive;		//	rule masks, bit k for k neighbours
+	uint64_t generation;			//	generation the log starts at
+	uint64_t seed;					//	seed the run was filled from, 0 if none
+	uint32_t interval;				//	generations between keyframes
+	uint32_t spare;
+	uint64_t reserved;
+};
+static_assert(sizeof(LogHeader) == 64, "the run log header is documented as 64 bytes");
+struct LogRecord{
+	enum Kind{ KEY = 0, STEP = 1, EDIT = 2, END = 3 };
+	uint32_t kind;
+	uint32_t spare;
+	uint64_t generation;			//	generation the cells are at after the record
+	uint64_t bytes;					//	size of the body that follows
+};
+
+/**
+ * @brief Recorder Object
+ * @details Appends an engine's history to a run log. Only tiles that changed in
+ * 			the last step, or were edited since, are compared against the cells
+ * 			last written, so the cost follows the activity rather than the size of
+ * 			the grid. Every change to the cells must be handed to step() or edit()
+ * 			before the next step, or the log falls out of step with the run.
+ */
+
+class Recorder{
+	public:
+		Recorder();
+		~Recorder();
+		bool open(const std::string & path, const Engine & engine, unsigned interval = 1000);
+		bool step(const Engine & engine);
+		bool edit(const Engine & engine);
+		bool close();
+		bool recording() const { return out != 0; }
+	private:
+		Recorder(const Recorder &);
+		Recorder & operator=(const Recorder &);
+		bool key(const Engine & engine);
+		bool delta(const Engine & engine, LogRecord::Kind kind);
+		bool record(LogRecord::Kind kind, uint64_t generation, const void * body, uint64_t bytes);
+		std::FILE * out;
+		Grid shadow;					//	cells as the log has them so far
+		std::vector<uint64_t> changes;
+		unsigned every;
+		unsigned long long keyed;		//	generation of the last keyframe
+		unsigned long long now;
+		bool ok;
+};
+
+/**
+ * @brief Replay Object
+ * @details Reads a run log back. open() indexes the records without reading their
+ * 			bodies; seek() then rebuilds any generation from the keyframe at or
+ * 			before it and the changes logged since, without stepping.
+ */
+
+class Replay{
+	public:
+		bool open(const std::string & path);
+		std::unique_ptr<Engine> seek(unsigned long long generation, int threads = 0) const;
+		unsigned long long first() const { return head.generation; }
+		unsigned long long last() const { return end; }
+		const Rule & rule() const { return rules; }
+	private:
+		struct Entry{
+			LogRecord record;
+			long offset;				//	where its body starts
+		};
+		std::string path;
+		LogHeader head;
+		Rule rules;
+		std::vector<Entry> index;
+		unsigned long long end;
+};
+
+#endif
@@ -0,0 +1,417 @@
+/**
+ * Conway's Game of Life simulation - domain decomposition
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "slab.h"
+#include "kernel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#define LIFE_SOCKETS 1
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+/**********************************SOCKET TRANSPORT CLASS**********************************/
+
+#if defined(LIFE_SOCKETS)
+/**
+ * @brief sendAll
+ * @details Write all of a buffer to a socket, however many writes it takes
+ */
+static bool sendAll(int fd, const void * data, size_t bytes){
+	const char * p = static_cast<const char *>(data);
+	while(bytes > 0){
+		ssize_t n = ::send(fd, p, bytes, MSG_NOSIGNAL);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return false;
+		p += n;
+		bytes -= static_cast<size_t>(n);
+	}
+	return true;
+}
+/**
+ * @brief receiveAll
+ * @details Read exactly bytes from a socket, false if it closes first
+ */
+static bool receiveAll(int fd, void * data, size_t bytes){
+	char * p = static_cast<char *>(data);
+	while(bytes > 0){
+		ssize_t n = ::recv(fd, p, bytes, 0);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return false;
+		p += n;
+		bytes -= static_cast<size_t>(n);
+	}
+	return true;
+}
+#endif
+
+SocketTransport::SocketTransport(int me, int count) : me(me), count(count), above(-1), below(-1){
+}
+SocketTransport::~SocketTransport(){
+	finish();
+}
+/**
+ * @brief launch
+ * @details Start a decomposition of ranks processes on this machine. Link i joins
+ * 			the bottom of rank i to the top of rank i+1, the last one wrapping round
+ * 			to rank 0, so a single rank on a torus swaps rows with itself. Must be
+ * 			called before any threads are started, since only the calling thread
+ * 			carries on in the forked ranks.
+ * @param ranks number of processes, this one included
+ * @return this process's transport, null if the sockets or processes couldn't be
+ * 			made (or there are none on this platform)
+ */
+std::unique_ptr<SocketTransport> SocketTransport::launch(int ranks){
+	std::unique_ptr<SocketTransport> none;
+#if defined(LIFE_SOCKETS)
+	if(ranks < 1)
+		return none;
+	std::vector<int> links(2 * ranks, -1);	//	[2i] rank i's end of link i, [2i+1] rank i+1's
+	std::vector<int> star(2 * ranks, -1);	//	[2r] rank 0's end of its link to rank r, [2r+1] rank r's
+	bool ok = true;
+	for(int i = 0; ok && i < ranks; i++)
+		ok = ::socketpair(AF_UNIX, SOCK_STREAM, 0, &links[2 * i]) == 0;
+	for(int r = 1; ok && r < ranks; r++)
+		ok = ::socketpair(AF_UNIX, SOCK_STREAM, 0, &star[2 * r]) == 0;
+	std::vector<pid_t> kids;
+	int me = 0;
+	std::fflush(0);		//	so nothing buffered is written once per process
+	for(int r = 1; ok && r < ranks; r++){
+		pid_t pid = ::fork();
+		if(pid == 0){
+			me = r;
+			kids.clear();
+			break;
+		}
+		if(pid < 0)
+			ok = false;
+		else
+			kids.push_back(pid);
+	}
+	std::unique_ptr<SocketTransport> link(new SocketTransport(me, ranks));
+	if(ok){
+		link->above = links[2 * ((me + ranks - 1) % ranks) + 1];
+		link->below = links[2 * me];
+		if(me == 0){
+			link->root.assign(ranks, -1);
+			for(int r = 1; r < ranks; r++)
+				link->root[r] = star[2 * r];
+		}
+		else
+			link->root.assign(1, star[2 * me + 1]);
+	}
+	link->children = kids;
+	for(size_t i = 0; i < links.size(); i++){
+		if(links[i] >= 0 && links[i] != link->above && links[i] != link->below)
+			::close(links[i]);
+	}
+	for(size_t i = 0; i < star.size(); i++){
+		if(star[i] >= 0 && std::find(link->root.begin(), link->root.end(), star[i]) == link->root.end())
+			::close(star[i]);
+	}
+	if(!ok)
+		return none;	//	ranks already forked see their links close and give up
+	return link;
+#else
+	(void)ranks;
+	return none;
+#endif
+}
+/**
+ * @brief exchange
+ * @details Send a block of rows to each neighbour and take one from each, all at
+ * 			once: the four transfers are polled together, so every rank keeps
+ * 			moving however big the blocks are compared with the socket buffers.
+ * 			A null pointer skips that side, as at a dead edge; the rank on the
+ * 			other side of it must skip it too.
+ * @param up rows for the rank above
+ * @param down rows for the rank below
+ * @param fromUp filled with the rows the rank above sent down
+ * @param fromDown filled with the rows the rank below sent up
+ * @param bytes size of every block
+ * @return false if a link failed
+ */
+bool SocketTransport::exchange(const void * up, const void * down, void * fromUp, void * fromDown, size_t bytes){
+#if defined(LIFE_SOCKETS)
+	struct Flow{
+		int fd;
+		const char * out;
+		char * in;
+		size_t sent, got;
+	};
+	Flow flows[2] = {
+		{ above, static_cast<const char *>(up), static_cast<char *>(fromUp), 0, 0 },
+		{ below, static_cast<const char *>(down), static_cast<char *>(fromDown), 0, 0 }
+	};
+	for(;;){
+		pollfd fds[2];
+		int n = 0;
+		int which[2];
+		for(int f = 0; f < 2; f++){
+			short events = 0;
+			if(flows[f].out && flows[f].sent < bytes)
+				events |= POLLOUT;
+			if(flows[f].in && flows[f].got < bytes)
+				events |= POLLIN;
+			if(!events)
+				continue;
+			if(flows[f].fd < 0)
+				return false;
+			fds[n].fd = flows[f].fd;
+			fds[n].events = events;
+			fds[n].revents = 0;
+			which[n++] = f;
+		}
+		if(n == 0)
+			return true;
+		if(::poll(fds, n, -1) < 0){
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		for(int k = 0; k < n; k++){
+			Flow & flow = flows[which[k]];
+			if(fds[k].revents & (POLLERR | POLLNVAL))
+				return false;
+			if(fds[k].revents & POLLOUT){
+				ssize_t put = ::send(flow.fd, flow.out + flow.sent, bytes - flow.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+				if(put < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+					return false;
+				if(put > 0)
+					flow.sent += static_cast<size_t>(put);
+			}
+			if(fds[k].revents & (POLLIN | POLLHUP)){
+				ssize_t got = ::recv(flow.fd, flow.in + flow.got, bytes - flow.got, MSG_DONTWAIT);
+				if(got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+					return false;
+				if(got > 0)
+					flow.got += static_cast<size_t>(got);
+			}
+		}
+	}
+#else
+	(void)up; (void)down; (void)fromUp; (void)fromDown; (void)bytes;
+	return false;
+#endif
+}
+/**
+ * @brief gather
+ * @details Collect a block from every rank on rank 0, in rank order. Blocks may
+ * 			differ in size; other ranks get nothing back.
+ * @param data this rank's block
+ * @param bytes its size
+ * @param all on rank 0, set to every rank's block one after another
+ * @return false if a link failed
+ */
+bool SocketTransport::gather(const void * data, size_t bytes, std::vector<char> & all){
+#if defined(LIFE_SOCKETS)
+	if(me != 0){
+		uint64_t size = bytes;
+		return sendAll(root[0], &size, sizeof(size)) && sendAll(root[0], data, bytes);
+	}
+	all.assign(static_cast<const char *>(data), static_cast<const char *>(data) + bytes);
+	for(int r = 1; r < count; r++){
+		uint64_t size = 0;
+		if(!receiveAll(root[r], &size, sizeof(size)))
+			return false;
+		size_t at = all.size();
+		all.resize(at + size);
+		if(size > 0 && !receiveAll(root[r], &all[at], size))
+			return false;
+	}
+	return true;
+#else
+	(void)data; (void)bytes; (void)all;
+	return false;
+#endif
+}
+/**
+ * @brief finish
+ * @details Close the links and, on rank 0, wait for the other ranks to exit
+ * @return false if one of them failed
+ */
+bool SocketTransport::finish(){
+	bool ok = true;
+#if defined(LIFE_SOCKETS)
+	if(above >= 0)
+		::close(above);
+	if(below >= 0 && below != above)
+		::close(below);
+	above = below = -1;
+	for(size_t i = 0; i < root.size(); i++){
+		if(root[i] >= 0)
+			::close(root[i]);
+	}
+	root.clear();
+	for(size_t i = 0; i < children.size(); i++){
+		int status = 0;
+		while(::waitpid(children[i], &status, 0) < 0 && errno == EINTR);
+		ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+	children.clear();
+#endif
+	return ok;
+}
+/*******************************End of SOCKET TRANSPORT CLASS******************************/
+
+
+/***************************************SLAB CLASS***************************************/
+
+/**
+ * @brief mirror
+ * @details Reverse a packed row left to right, for rows crossing the twisted edge
+ * 			of a Klein bottle
+ */
+static void mirror(uint64_t * row, size_t n, int wide){
+	std::vector<uint64_t> flipped(n, 0);
+	for(size_t i = 0; i < n; i++){
+		for(uint64_t w = row[i]; w; w &= w - 1){
+			int x = wide - 1 - static_cast<int>(i * 64 + lowest(w));
+			if(x >= 0)
+				flipped[x >> 6] |= 1ULL << (x & 63);
+		}
+	}
+	std::copy(flipped.begin(), flipped.end(), row);
+}
+/**
+ * @brief Slab
+ * @details This rank's band of a wide x tall grid, the rows split as evenly as
+ * 			they go. Each band must be at least depth rows tall.
+ * @param link transport to the other ranks
+ * @param wide number of cells across the whole grid
+ * @param tall number of cells down the whole grid
+ * @param rule birth/survive rule
+ * @param topology edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+ * @param depth halo rows each side, and generations between swaps
+ * @param threads stepping threads for this rank, 0 for one per core
+ */
+Slab::Slab(Transport & link, int wide, int tall, const Rule & rule, int topology, int depth, int threads)
+		: link(link), wide(wide), tall(tall), topology(topology), depth(std::max(depth, 1)){
+	int r = link.rank(), n = link.ranks();
+	bool wraps = topology == 1 || topology == 2;
+	y0 = static_cast<int>(static_cast<long long>(tall) * r / n);
+	y1 = static_cast<int>(static_cast<long long>(tall) * (r + 1) / n);
+	above = (wraps || r > 0) ? this->depth : 0;
+	below = (wraps || r + 1 < n) ? this->depth : 0;
+	cells.reset(new Engine(wide, above + (y1 - y0) + below, rule, topology, threads));
+	size_t block = static_cast<size_t>(this->depth) * cells->cells().words();
+	out.assign(2 * block, 0);
+	in.assign(2 * block, 0);
+}
+/**
+ * @brief fill
+ * @details Random cells, the same ones Engine::fill() gives the whole grid
+ */
+void Slab::fill(unsigned seed, double density){
+	cells->fill(seed, density, static_cast<long long>(y0) - above);
+}
+/**
+ * @brief exchange
+ * @details Send this slab's top and bottom depth rows to its neighbours and take
+ * 			theirs into the halos. Rows crossing a Klein bottle's wrap are turned
+ * 			round on the way in.
+ */
+bool Slab::exchange(){
+	const Grid & grid = cells->cells();
+	size_t n = grid.words();
+	size_t block = static_cast<size_t>(depth) * n;
+	int rows = y1 - y0;
+	for(int j = 0; j < depth; j++){
+		std::copy(grid.row(above + j), grid.row(above + j) + n, &out[j * n]);
+		std::copy(grid.row(above + rows - depth + j), grid.row(above + rows - depth + j) + n, &out[block + j * n]);
+	}
+	bool up = above > 0, down = below > 0;
+	if(!link.exchange(up ? &out[0] : 0, down ? &out[block] : 0, up ? &in[0] : 0, down ? &in[block] : 0,
+			block * sizeof(uint64_t)))
+		return false;
+	bool twisted = topology == 2;
+	for(int j = 0; j < depth; j++){
+		if(up){
+			if(twisted && link.rank() == 0)
+				mirror(&in[j * n], n, wide);
+			cells->setRow(j, &in[j * n]);
+		}
+		if(down){
+			if(twisted && link.rank() + 1 == link.ranks())
+				mirror(&in[block + j * n], n, wide);
+			cells->setRow(above + rows + j, &in[block + j * n]);
+		}
+	}
+	return true;
+}
+/**
+ * @brief run
+ * @details Advance a number of generations, swapping halos before every block
+ * 			of up to depth of them
+ * @return false if the transport failed, leaving the slab part way
+ */
+bool Slab::run(unsigned long long gens){
+	for(unsigned long long done = 0; done < gens; ){
+		if(!exchange())
+			return false;
+		unsigned long long block = std::min<unsigned long long>(depth, gens - done);
+		cells->run(block);
+		done += block;
+	}
+	return true;
+}
+/**
+ * @brief population
+ * @details Live cells in this slab's own rows
+ */
+uint64_t Slab::population() const{
+	const Grid & grid = cells->cells();
+	size_t n = grid.words();
+	uint64_t pop = 0;
+	for(int y = above; y < above + (y1 - y0); y++){
+		const uint64_t * row = grid.row(y);
+		for(size_t i = 0; i < n; i++)
+			pop += popcount(row[i]);
+	}
+	return pop;
+}
+/**
+ * @brief gather
+ * @details Put the whole grid together on rank 0. Every rank must call it.
+ * @param whole on rank 0, set to the whole grid
+ * @return false if the transport failed
+ */
+bool Slab::gather(Grid & whole){
+	const Grid & grid = cells->cells();
+	size_t n = grid.words();
+	std::vector<uint64_t> mine(static_cast<size_t>(y1 - y0) * n);
+	for(int y = y0; y < y1; y++)
+		std::copy(grid.row(above + y - y0), grid.row(above + y - y0) + n, &mine[static_cast<size_t>(y - y0) * n]);
+	std::vector<char> all;
+	if(!link.gather(mine.data(), mine.size() * sizeof(uint64_t), all))
+		return false;
+	if(link.rank() != 0)
+		return true;
+	Grid full(wide, tall);
+	if(all.size() != static_cast<size_t>(tall) * n * sizeof(uint64_t))
+		return false;
+	for(int y = 0; y < tall; y++)
+		std::memcpy(full.row(y), &all[static_cast<size_t>(y) * n * sizeof(uint64_t)], n * sizeof(uint64_t));
+	whole = std::move(full);
+	return true;
+}
+/***********************************End of SLAB CLASS************************************/
@@ -0,0 +1,103 @@
+/**
+ * Conway's Game of Life simulation - domain decomposition
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_SLAB_H
+#define LIFE_SLAB_H
+
+#include "engine.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief Transport Object
+ * @details How the ranks of a decomposed grid talk to each other. Ranks sit in a
+ * 			column, rank 0 at the top, and each only ever swaps rows with the ones
+ * 			above and below it (the last and first being neighbours across a
+ * 			wrapping edge), plus a gather to rank 0 at the end. Every rank must
+ * 			make the same calls in the same order.
+ */
+
+class Transport{
+	public:
+		virtual ~Transport() {}
+		virtual int rank() const = 0;
+		virtual int ranks() const = 0;
+		virtual bool exchange(const void * up, const void * down, void * fromUp, void * fromDown, size_t bytes) = 0;
+		virtual bool gather(const void * data, size_t bytes, std::vector<char> & all) = 0;
+};
+
+/**
+ * @brief SocketTransport Object
+ * @details Transport between processes on one machine over Unix domain socket
+ * 			pairs. launch() makes a pair for every link, neighbour to neighbour and
+ * 			each rank to rank 0, then forks the other ranks off; every process keeps
+ * 			just the ends that are its own. The caller carries on as rank 0, and
+ * 			waits for the rest when its transport is destroyed.
+ */
+
+class SocketTransport : public Transport{
+	public:
+		static std::unique_ptr<SocketTransport> launch(int ranks);
+		~SocketTransport();
+		int rank() const { return me; }
+		int ranks() const { return count; }
+		bool exchange(const void * up, const void * down, void * fromUp, void * fromDown, size_t bytes);
+		bool gather(const void * data, size_t bytes, std::vector<char> & all);
+		bool finish();
+	private:
+		SocketTransport(int me, int count);
+		SocketTransport(const SocketTransport &);
+		SocketTransport & operator=(const SocketTransport &);
+		int me;
+		int count;
+		int above;						//	link to the rank above, -1 for none
+		int below;						//	and to the one below
+		std::vector<int> root;			//	rank 0's link to each rank, or this rank's to rank 0
+		std::vector<int> children;		//	process ids of the other ranks, on rank 0
+};
+
+/**
+ * @brief Slab Object
+ * @details One rank's share of a grid too big for one process: a band of whole
+ * 			rows, stepped by an ordinary Engine with depth extra rows of halo on
+ * 			each side that has a neighbour. The halos are swapped every depth
+ * 			generations; in between, the wrong cells creeping in from the far edge
+ * 			of a halo move a row a generation and don't reach the slab's own rows
+ * 			in time. Where the grid has a dead or mirrored edge there is no halo,
+ * 			and the engine's own edge policy does the work, as it does left and
+ * 			right for every topology.
+ */
+
+class Slab{
+	public:
+		Slab(Transport & link, int wide, int tall, const Rule & rule, int topology, int depth, int threads = 0);
+		void fill(unsigned seed, double density);
+		bool run(unsigned long long gens);
+		bool gather(Grid & whole);
+		uint64_t population() const;
+		Engine & engine() { return *cells; }
+		int first() const { return y0; }
+		int last() const { return y1; }
+		int top() const { return above; }
+		unsigned long long generation() const { return cells->generation(); }
+	private:
+		bool exchange();
+		Transport & link;
+		std::unique_ptr<Engine> cells;
+		std::vector<uint64_t> out;		//	rows going up then down
+		std::vector<uint64_t> in;		//	rows coming from above then below
+		int wide, tall;
+		int topology;
+		int depth;
+		int y0, y1;						//	rows of the whole grid this slab owns
+		int above, below;				//	halo rows the engine has over and under them
+};
+
+#endif
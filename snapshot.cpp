@@ -0,0 +1,343 @@
+/**
+ * Conway's Game of Life simulation - snapshots
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#include "snapshot.h"
+#include "profile.h"
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define LIFE_MMAP 1
+#endif
+
+static const char MAGIC[8] = { 'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P' };
+static const uint32_t RUN = 0x80000000u;		//	RLE token flag: count copies of one word
+
+/**************************************SNAPSHOT SAVE*************************************/
+
+/**
+ * @brief Encoder Object
+ * @details Packs a stream of words into RLE tokens, a 32-bit count then the words.
+ * 			With the top bit of the count set, the one word that follows repeats
+ * 			count times; otherwise count words follow as they are. Tokens go out
+ * 			through a buffer of about a megabyte.
+ */
+
+class Encoder{
+	public:
+		Encoder(std::FILE * out) : out(out), run(0), bytes(0), ok(true) {}
+		void put(uint64_t w);
+		bool finish();
+		uint64_t size() const { return bytes; }
+	private:
+		void flushRun();
+		void flushLiterals();
+		void emit(const void * p, size_t n);
+		std::FILE * out;
+		std::vector<uint64_t> literals;
+		std::vector<unsigned char> buffer;
+		uint64_t word;
+		uint32_t run;
+		uint64_t bytes;
+		bool ok;
+};
+void Encoder::emit(const void * p, size_t n){
+	const unsigned char * c = static_cast<const unsigned char *>(p);
+	buffer.insert(buffer.end(), c, c + n);
+	bytes += n;
+	if(buffer.size() >= (1u << 20)){
+		ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+		buffer.clear();
+	}
+}
+void Encoder::flushLiterals(){
+	if(literals.empty())
+		return;
+	uint32_t n = static_cast<uint32_t>(literals.size());
+	emit(&n, 4);
+	emit(literals.data(), literals.size() * 8);
+	literals.clear();
+}
+void Encoder::flushRun(){
+	if(run == 0)
+		return;
+	if(run < 3){	//	too short to be worth a token of its own
+		literals.insert(literals.end(), run, word);
+		if(literals.size() >= RUN / 2)
+			flushLiterals();
+	}
+	else{
+		flushLiterals();
+		uint32_t n = run | RUN;
+		emit(&n, 4);
+		emit(&word, 8);
+	}
+	run = 0;
+}
+void Encoder::put(uint64_t w){
+	if(run > 0 && w == word && run < RUN - 1){
+		run++;
+		return;
+	}
+	flushRun();
+	word = w;
+	run = 1;
+}
+bool Encoder::finish(){
+	flushRun();
+	flushLiterals();
+	ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+	buffer.clear();
+	return ok;
+}
+/**
+ * @brief packCells
+ * @details Write the cell words of every row as RLE tokens, the body of an RLE
+ * 			snapshot
+ * @param out file to write at its current position
+ * @param grid cells to write
+ * @param bytes set to the number of bytes written
+ * @return false if the file couldn't be written
+ */
+bool packCells(std::FILE * out, const Grid & grid, uint64_t & bytes){
+	Encoder enc(out);
+	size_t n = grid.words();
+	uint64_t tail = grid.tailMask();
+	for(int y = 0; y < grid.height(); y++){
+		const uint64_t * row = grid.row(y);
+		for(size_t i = 0; i < n; i++)
+			enc.put(i + 1 < n ? row[i] : row[i] & tail);
+	}
+	bool ok = enc.finish();
+	bytes = enc.size();
+	return ok;
+}
+/**
+ * @brief writeImage
+ * @details Write a grid's image, the body of a raw snapshot, with everything but
+ * 			the cells dead
+ * @param out file to write at its current position
+ * @param grid cells to write
+ * @return false if the file couldn't be written
+ */
+static bool writeImage(std::FILE * out, const Grid & grid){
+	size_t n = grid.words(), pitch = grid.stride();
+	std::vector<uint64_t> line(8 + pitch, 0);
+	bool ok = std::fwrite(line.data(), sizeof(uint64_t), 8 + pitch, out) == 8 + pitch;	//	front guard line and top halo
+	for(int y = 0; ok && y < grid.height(); y++){
+		std::copy(grid.row(y), grid.row(y) + n, line.begin());
+		if(n)
+			line[n - 1] &= grid.tailMask();
+		ok = std::fwrite(line.data(), sizeof(uint64_t), pitch, out) == pitch;
+	}
+	std::fill(line.begin(), line.end(), 0);
+	return ok && std::fwrite(line.data(), sizeof(uint64_t), pitch + 8, out) == pitch + 8;	//	bottom halo and back guard line
+}
+/**
+ * @brief saveSnapshot
+ * @details Write the engine's cells and the header needed to carry on from them. A
+ * 			raw body goes out row by row from the grid with the guard lines, halo
+ * 			rows and padding written dead, whatever the edges last left there; an
+ * 			RLE body is encoded on the way and its size patched into the header
+ * 			after.
+ * @param path file to write
+ * @param engine engine to save
+ * @param rle compress the body
+ * @return false if the file couldn't be written
+ */
+bool saveSnapshot(const std::string & path, const Engine & engine, bool rle){
+	LIFE_TIME(SNAPSHOT);
+	const Grid & grid = engine.cells();
+	SnapshotHeader h;
+	std::memset(&h, 0, sizeof(h));
+	std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = SnapshotHeader::VERSION;
+	h.body = rle ? SnapshotHeader::RLE : SnapshotHeader::RAW;
+	h.wide = grid.width();
+	h.tall = grid.height();
+	h.birth = engine.rule().birth;
+	h.survive = engine.rule().survive;
+	h.generation = engine.generation();
+	h.seed = engine.seed();
+	h.topology = engine.topology();
+	h.pitch = static_cast<uint32_t>(grid.stride());
+	h.bytes = rle ? 0 : grid.imageWords() * sizeof(uint64_t);
+
+	std::FILE * out = std::fopen(path.c_str(), "wb");
+	if(!out)
+		return false;
+	bool ok = std::fwrite(&h, sizeof(h), 1, out) == 1;
+	if(ok && !rle)
+		ok = writeImage(out, grid);
+	else if(ok){
+		ok = packCells(out, grid, h.bytes);
+		ok = ok && std::fseek(out, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, out) == 1;
+	}
+	ok = (std::fclose(out) == 0) && ok;
+	if(!ok)
+		std::remove(path.c_str());
+	return ok;
+}
+/**********************************End of SNAPSHOT SAVE**********************************/
+
+
+/**************************************SNAPSHOT LOAD*************************************/
+
+/**
+ * @brief readFile
+ * @details Map a whole file copy-on-write, or read it into memory where there's no
+ * 			mmap. Writes to the returned bytes never reach the file.
+ * @param path file to open
+ * @param size set to the file size
+ * @return bytes of the file, null if it couldn't be read
+ */
+static std::shared_ptr<void> readFile(const std::string & path, size_t & size){
+#if defined(LIFE_MMAP)
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return std::shared_ptr<void>();
+	struct stat st;
+	void * map = MAP_FAILED;
+	if(::fstat(fd, &st) == 0 && st.st_size > 0){
+		size = static_cast<size_t>(st.st_size);
+		map = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if(map == MAP_FAILED)
+		return std::shared_ptr<void>();
+	size_t length = size;
+	return std::shared_ptr<void>(map, [length](void * p){ ::munmap(p, length); });
+#else
+	std::FILE * in = std::fopen(path.c_str(), "rb");
+	if(!in)
+		return std::shared_ptr<void>();
+	std::shared_ptr< std::vector<uint64_t> > data = std::make_shared< std::vector<uint64_t> >();
+	std::vector<unsigned char> chunk(1 << 20);
+	size_t got;
+	size = 0;
+	while((got = std::fread(chunk.data(), 1, chunk.size(), in)) > 0){
+		data->resize((size + got + 7) / 8 + 8);
+		std::memcpy(reinterpret_cast<unsigned char *>(data->data()) + size, chunk.data(), got);
+		size += got;
+	}
+	std::fclose(in);
+	data->resize(data->size() + 8);
+	uintptr_t p = (reinterpret_cast<uintptr_t>(data->data()) + 63) & ~static_cast<uintptr_t>(63);
+	std::memmove(reinterpret_cast<void *>(p), data->data(), size);	//	align like a mapping would be
+	return std::shared_ptr<void>(data, reinterpret_cast<void *>(p));
+#endif
+}
+/**
+ * @brief unpackCells
+ * @details Unpack RLE tokens written by packCells() into the rows of a grid of
+ * 			the same size
+ * @return false if the tokens are damaged or the wrong size
+ */
+bool unpackCells(const unsigned char * p, const unsigned char * end, Grid & grid){
+	size_t n = grid.words();
+	uint64_t total = static_cast<uint64_t>(n) * grid.height(), at = 0;
+	uint64_t tail = grid.tailMask();
+	while(p < end){
+		uint32_t count;
+		if(end - p < 4)
+			return false;
+		std::memcpy(&count, p, 4);
+		p += 4;
+		bool run = (count & RUN) != 0;
+		count &= ~RUN;
+		if(count == 0 || count > total - at || (end - p) < static_cast<ptrdiff_t>(run ? 8 : 8 * static_cast<uint64_t>(count)))
+			return false;
+		for(uint32_t i = 0; i < count; i++, at++){
+			uint64_t w;
+			std::memcpy(&w, p + (run ? 0 : 8 * static_cast<size_t>(i)), 8);
+			size_t x = static_cast<size_t>(at % n);
+			grid.row(static_cast<int>(at / n))[x] = x + 1 < n ? w : w & tail;
+		}
+		p += run ? 8 : 8 * static_cast<size_t>(count);
+	}
+	return at == total;
+}
+/**
+ * @brief blankBorder
+ * @details Check that everything in a grid's image other than its cells is dead:
+ * 			the guard lines, the halo rows and the padding past the last cell of
+ * 			each row, as writeImage() leaves them. Every kernel counts on it, so a
+ * 			raw body that breaks it can't be stepped.
+ * @param grid grid over a loaded image
+ * @return false if a bit outside the cells is set
+ */
+static bool blankBorder(const Grid & grid){
+	const uint64_t * image = grid.image();
+	size_t n = grid.words(), pitch = grid.stride();
+	uint64_t any = 0;
+	for(const uint64_t * p = image; p < grid.row(0); p++)
+		any |= *p;
+	for(int y = 0; y < grid.height(); y++){
+		const uint64_t * row = grid.row(y);
+		any |= row[n - 1] & ~grid.tailMask();
+		for(size_t i = n; i < pitch; i++)
+			any |= row[i];
+	}
+	for(const uint64_t * p = grid.row(grid.height()); p < image + grid.imageWords(); p++)
+		any |= *p;
+	return any == 0;
+}
+/**
+ * @brief loadSnapshot
+ * @details Read a snapshot back into an engine set up as the one that saved it. A
+ * 			raw body is stepped where it lies in the mapped file, pages being copied
+ * 			only as the engine writes to them, once its halo and padding are found
+ * 			blank; an RLE body is unpacked into a new grid.
+ * @param path file to read
+ * @param threads stepping threads, 0 for one per core
+ * @return the engine, null if the file is missing, damaged or not a snapshot
+ */
+std::unique_ptr<Engine> loadSnapshot(const std::string & path, int threads){
+	LIFE_TIME(SNAPSHOT);
+	std::unique_ptr<Engine> engine;
+	size_t size = 0;
+	std::shared_ptr<void> file = readFile(path, size);
+	if(!file || size < sizeof(SnapshotHeader))
+		return engine;
+	SnapshotHeader h;
+	std::memcpy(&h, file.get(), sizeof(h));
+	const unsigned char * body = static_cast<const unsigned char *>(file.get()) + sizeof(h);
+	if(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != SnapshotHeader::VERSION || h.topology > 3
+			|| h.wide == 0 || h.tall == 0 || h.wide > (1u << 30) || h.tall > (1u << 30) || h.bytes > size - sizeof(h))
+		return engine;
+
+	Rule rule;
+	if(!rule.assign(h.birth, h.survive))
+		return engine;
+
+	int wide = static_cast<int>(h.wide), tall = static_cast<int>(h.tall);
+	if(h.body == SnapshotHeader::RAW){
+		if(h.pitch != Grid::pitchFor(wide) || h.bytes != (8 + (static_cast<uint64_t>(tall) + 2) * h.pitch + 8) * 8)
+			return engine;
+		uint64_t * image = reinterpret_cast<uint64_t *>(static_cast<unsigned char *>(file.get()) + sizeof(h));
+		Grid grid(wide, tall, image, file);
+		if(!blankBorder(grid))
+			return engine;
+		engine.reset(new Engine(std::move(grid), rule, h.topology, threads, h.generation, h.seed));
+	}
+	else if(h.body == SnapshotHeader::RLE){
+		Grid grid(wide, tall);
+		if(!unpackCells(body, body + h.bytes, grid))
+			return engine;
+		engine.reset(new Engine(std::move(grid), rule, h.topology, threads, h.generation, h.seed));
+	}
+	return engine;
+}
+/**********************************End of SNAPSHOT LOAD**********************************/
@@ -0,0 +1,50 @@
+/**
+ * Conway's Game of Life simulation - snapshots
+ * By: James Coan
+ * ©2015
+ *
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *
+ */
+
+#ifndef LIFE_SNAPSHOT_H
+#define LIFE_SNAPSHOT_H
+
+#include "engine.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief Snapshot Header
+ * @details First 64 bytes of a snapshot file, in the byte order of the machine
+ * 			that wrote it, like the body words. A raw body is the
+ * 			grid's own image (see Grid::imageWords()) so it starts on a 64 byte
+ * 			boundary and can be mapped and stepped where it lies; an RLE body holds
+ * 			just the cell words of each row, runs of a repeated word packed down
+ * 			to a count and the word.
+ */
+
+struct SnapshotHeader{
+	enum{ VERSION = 1 };
+	enum Body{ RAW = 0, RLE = 1 };
+	char magic[8];					//	"LIFESNAP"
+	uint32_t version;
+	uint32_t body;					//	RAW or RLE
+	uint32_t wide, tall;			//	grid size in cells
+	uint32_t birth, survive;		//	rule masks, bit k for k neighbours
+	uint64_t generation;
+	uint64_t seed;					//	seed the run was filled from, 0 if none
+	uint32_t topology;				//	edges: 0 dead, 1 torus, 2 klein bottle, 3 mirror
+	uint32_t pitch;					//	words per row of a raw body
+	uint64_t bytes;					//	size of the body that follows
+};
+static_assert(sizeof(SnapshotHeader) == 64, "a raw body must start on a 64 byte boundary");
+
+bool saveSnapshot(const std::string & path, const Engine & engine, bool rle = false);
+std::unique_ptr<Engine> loadSnapshot(const std::string & path, int threads = 0);
+bool packCells(std::FILE * out, const Grid & grid, uint64_t & bytes);
+bool unpackCells(const unsigned char * p, const unsigned char * end, Grid & grid);
+
+#endif
@@ -0,0 +1,262 @@
+/**
+ * Conway's Game of Life simulation - unbounded world
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#include "world.h"
+#include "kernel.h"
+#include <algorithm>
+#include <cstring>
+
+/**************************************WORLD CLASS***************************************/
+
+/**
+ * @brief World
+ * @details Empty universe at generation 0
+ * @param rule birth/survive rule
+ */
+World::World(const Rule & rule) : cur(0), gens(0), rule(rule){
+	std::fill(blank, blank + 64, 0);
+}
+/**
+ * @brief clear
+ * @details Free every chunk
+ */
+void World::clear(){
+	map.clear();
+	gens = 0;
+}
+/**
+ * @brief key
+ * @details Hash map key of a chunk, both coordinates packed into one word
+ */
+uint64_t World::key(long long cx, long long cy){
+	return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+/**
+ * @brief find
+ * @details Chunk at chunk coordinates (cx,cy), NULL if that area is blank
+ */
+World::Chunk * World::find(long long cx, long long cy) const{
+	std::unordered_map< uint64_t, std::unique_ptr<Chunk> >::const_iterator it = map.find(key(cx, cy));
+	return it == map.end() ? NULL : it->second.get();
+}
+/**
+ * @brief make
+ * @details Chunk at chunk coordinates (cx,cy), allocated blank if it's missing
+ */
+World::Chunk & World::make(long long cx, long long cy){
+	std::unique_ptr<Chunk> & slot = map[key(cx, cy)];
+	if(!slot){
+		slot.reset(new Chunk());
+		slot->cx = cx;
+		slot->cy = cy;
+		std::memset(slot->cells, 0, sizeof(slot->cells));
+		slot->alive = false;
+	}
+	return *slot;
+}
+/**
+ * @brief get
+ * @details Read one cell of the universe
+ */
+bool World::get(long long x, long long y) const{
+	long long cx = x >> 6, cy = y >> 6;		//	arithmetic shifts floor negative coordinates
+	const Chunk * c = find(cx, cy);
+	return c && ((c->cells[cur][y - cy * 64] >> (x - cx * 64)) & 1);
+}
+/**
+ * @brief set
+ * @details Write one cell of the universe. A blank chunk is left for the next
+ * 			step() to free.
+ */
+void World::set(long long x, long long y, bool alive){
+	long long cx = x >> 6, cy = y >> 6;
+	if(!alive && !find(cx, cy))
+		return;
+	uint64_t & w = make(cx, cy).cells[cur][y - cy * 64];
+	uint64_t bit = 1ULL << (x - cx * 64);
+	w = alive ? (w | bit) : (w & ~bit);
+}
+/**
+ * @brief setRun
+ * @details Bring a row of cells to life, a chunk row at a time
+ * @param x x-axis position of the first cell
+ * @param y y-axis position
+ * @param n number of cells
+ */
+void World::setRun(long long x, long long y, long long n){
+	long long cy = y >> 6;
+	while(n > 0){
+		long long cx = x >> 6;
+		int s = static_cast<int>(x - cx * 64);
+		int k = static_cast<int>(std::min(n, static_cast<long long>(64 - s)));
+		make(cx, cy).cells[cur][y - cy * 64] |= (k == 64 ? ~0ULL : ((1ULL << k) - 1)) << s;
+		x += k;
+		n -= k;
+	}
+}
+/**
+ * @brief load
+ * @details Copy the live cells of a grid into the universe, grid cell (0,0)
+ * 			going to (x,y). Cells already in the universe are kept.
+ */
+void World::load(const Grid & grid, long long x, long long y){
+	for(int r = 0; r < grid.height(); r++){
+		const uint64_t * row = grid.row(r);
+		for(size_t i = 0; i < grid.words(); i++)
+			for(uint64_t w = (i + 1 == grid.words()) ? row[i] & grid.tailMask() : row[i]; w; w &= w - 1)
+				set(x + static_cast<long long>(i) * 64 + lowest(w), y + r, true);
+	}
+}
+/**
+ * @brief store
+ * @details Copy the window of the universe with its corner at (x,y) into a grid
+ * @param grid destination, cleared first
+ */
+void World::store(Grid & grid, long long x, long long y) const{
+	grid.clear();
+	std::unordered_map< uint64_t, std::unique_ptr<Chunk> >::const_iterator it;
+	for(it = map.begin(); it != map.end(); ++it){
+		const Chunk & c = *it->second;
+		long long ox = c.cx * 64 - x, oy = c.cy * 64 - y;
+		if(ox <= -64 || oy <= -64 || ox >= grid.width() || oy >= grid.height())
+			continue;
+		for(int r = 0; r < 64; r++){
+			if(oy + r < 0 || oy + r >= grid.height())
+				continue;
+			for(uint64_t w = c.cells[cur][r]; w; w &= w - 1){
+				int bit = lowest(w);
+				if(ox + bit >= 0 && ox + bit < grid.width())
+					grid.set(static_cast<int>(ox + bit), static_cast<int>(oy + r), true);
+			}
+		}
+	}
+}
+/**
+ * @brief population
+ * @details Number of live cells in the universe
+ */
+uint64_t World::population() const{
+	uint64_t pop = 0;
+	std::unordered_map< uint64_t, std::unique_ptr<Chunk> >::const_iterator it;
+	for(it = map.begin(); it != map.end(); ++it)
+		for(int r = 0; r < 64; r++)
+			pop += popcount(it->second->cells[cur][r]);
+	return pop;
+}
+/**
+ * @brief advanceAs
+ * @details Step one chunk into its back buffer under rule R. The rows above, beside
+ * 			and below are pulled from the neighbouring chunks into a 66 x 3 word
+ * 			frame so the grid kernel can run on it unchanged.
+ */
+template<class R> void World::advanceAs(Chunk & c){
+	uint64_t frame[66][3];
+	for(int r = -1; r <= 64; r++){
+		int band = (r < 0) ? 0 : (r > 63 ? 6 : 3);
+		int rr = r & 63;
+		frame[r+1][0] = c.near[band][rr];
+		frame[r+1][1] = c.near[band+1][rr];
+		frame[r+1][2] = c.near[band+2][rr];
+	}
+	uint64_t * out = c.cells[cur ^ 1];
+	uint64_t any = 0;
+	for(int r = 0; r < 64; r++){
+		out[r] = lifeWord<uint64_t, R>(frame[r], frame[r+1], frame[r+2], rule);
+		any |= out[r];
+	}
+	c.alive = any != 0;
+}
+/**
+ * @brief advance
+ * @details Step one chunk with the kernel for this world's rule
+ */
+void World::advance(Chunk & c){
+	switch(rule.kind){
+		case Rule::CONWAY:
+			advanceAs<ConwayRule>(c);
+			break;
+		case Rule::HIGHLIFE:
+			advanceAs<HighLifeRule>(c);
+			break;
+		case Rule::DAYNIGHT:
+			advanceAs<DayNightRule>(c);
+			break;
+		case Rule::SEEDS:
+			advanceAs<SeedsRule>(c);
+			break;
+		default:
+			advanceAs<TableRule>(c);
+			break;
+	}
+}
+/**
+ * @brief step
+ * @details Advance the universe one generation. Chunks with live cells on an
+ * 			edge first get their missing neighbours on that side, which is the only
+ * 			way a blank area can come to life. All chunks are then stepped across
+ * 			the pool and the ones left blank are freed.
+ * @param pool threads to step chunks on
+ */
+void World::step(Pool & pool){
+	std::vector<Chunk *> list;
+	list.reserve(map.size());
+	std::unordered_map< uint64_t, std::unique_ptr<Chunk> >::iterator it;
+	for(it = map.begin(); it != map.end(); ++it)
+		list.push_back(it->second.get());
+	for(size_t i = 0, n = list.size(); i < n; i++){
+		const uint64_t * rows = list[i]->cells[cur];
+		long long cx = list[i]->cx, cy = list[i]->cy;
+		uint64_t left = 0, right = 0;
+		for(int r = 0; r < 64; r++){
+			left |= rows[r] & 1;
+			right |= rows[r] >> 63;
+		}
+		bool top = rows[0] != 0, bottom = rows[63] != 0;
+		if(top)
+			make(cx, cy - 1);
+		if(bottom)
+			make(cx, cy + 1);
+		if(left)
+			make(cx - 1, cy);
+		if(right)
+			make(cx + 1, cy);
+		if(rows[0] & 1)
+			make(cx - 1, cy - 1);
+		if(rows[0] >> 63)
+			make(cx + 1, cy - 1);
+		if(rows[63] & 1)
+			make(cx - 1, cy + 1);
+		if(rows[63] >> 63)
+			make(cx + 1, cy + 1);
+	}
+	list.clear();
+	for(it = map.begin(); it != map.end(); ++it){
+		Chunk & c = *it->second;
+		for(int k = 0; k < 9; k++){
+			const Chunk * n = find(c.cx + k % 3 - 1, c.cy + k / 3 - 1);
+			c.near[k] = n ? n->cells[cur] : blank;
+		}
+		list.push_back(&c);
+	}
+	int parts = static_cast<int>(std::min<size_t>(pool.size(), list.size() / 16 + 1));
+	pool.run(parts, [this, &list, parts](int part){
+		size_t a = list.size() * part / parts, b = list.size() * (part + 1) / parts;
+		for(size_t i = a; i < b; i++)
+			advance(*list[i]);
+	});
+	cur ^= 1;
+	for(it = map.begin(); it != map.end(); ){
+		if(it->second->alive)
+			++it;
+		else
+			it = map.erase(it);
+	}
+	gens++;
+}
+/**********************************End of WORLD CLASS************************************/
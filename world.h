@@ -0,0 +1,60 @@
+/**
+ * Conway's Game of Life simulation - unbounded world
+ * By: James Coan
+ * ©2015
+ * 
+ * https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ * 
+ */
+
+#ifndef LIFE_WORLD_H
+#define LIFE_WORLD_H
+
+#include "engine.h"
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief World Object
+ * @details Unbounded universe made of 64x64 chunks held in a hash map keyed by
+ * 			chunk coordinates. A chunk is allocated when live cells reach its edge
+ * 			and freed as soon as it goes blank, so memory follows the population
+ * 			rather than the bounding box. Each chunk double-buffers its own cells.
+ * 			Chunk coordinates are keyed as 32-bit values, so the universe spans
+ * 			2^37 cells each way.
+ */
+
+class World{
+	public:
+		World(const Rule & rule = Rule());
+		bool get(long long x, long long y) const;
+		void set(long long x, long long y, bool alive);
+		void setRun(long long x, long long y, long long n);
+		void load(const Grid & grid, long long x = 0, long long y = 0);
+		void store(Grid & grid, long long x = 0, long long y = 0) const;
+		void step(Pool & pool);
+		void clear();
+		uint64_t population() const;
+		size_t chunks() const { return map.size(); }
+		unsigned long long generation() const { return gens; }
+	private:
+		struct Chunk{
+			long long cx, cy;
+			uint64_t cells[2][64];		//	row y of the chunk is word y, cell x is bit x
+			const uint64_t * near[9];	//	front rows of the 3x3 block around this chunk
+			bool alive;
+		};
+		static uint64_t key(long long cx, long long cy);
+		Chunk * find(long long cx, long long cy) const;
+		Chunk & make(long long cx, long long cy);
+		void advance(Chunk & c);
+		template<class R> void advanceAs(Chunk & c);
+		std::unordered_map< uint64_t, std::unique_ptr<Chunk> > map;
+		uint64_t blank[64];
+		int cur;
+		unsigned long long gens;
+		Rule rule;
+};
+
+#endif